@@ -14,6 +14,9 @@ set_target_properties(sqlite3 PROPERTIES FOLDER 3rdparty/Static)
 
 set_target_properties(sqlite3 PROPERTIES LINKER_LANGUAGE C)
 
+## fts5 provides the trigram tokenizer used for the substring search of paths
+target_compile_definitions(sqlite3 PRIVATE SQLITE_ENABLE_FTS5)
+
 set_target_properties(sqlite3 PROPERTIES RUNTIME_OUTPUT_DIRECTORY "${FINAL_BIN_DIR}")
 set_target_properties(sqlite3 PROPERTIES RUNTIME_OUTPUT_DIRECTORY_DEBUG "${FINAL_BIN_DIR}")
 set_target_properties(sqlite3 PROPERTIES RUNTIME_OUTPUT_DIRECTORY_RELEASE "${FINAL_BIN_DIR}")
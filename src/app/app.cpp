@@ -2,12 +2,28 @@
 
 #include <app/headers/kunaiBuild.h>
 #include <app/model/model.h>
+#include <app/utils/ndjson.h>
+#include <app/utils/line_reader.h>
+#include <app/utils/path_matcher.h>
 
 #include <ezlibs/ezApp.hpp>
 #include <ezlibs/ezArgs.hpp>
 #include <ezlibs/ezFmt.hpp>
+#include <ezlibs/ezFile.hpp>
 
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
 
@@ -15,18 +31,44 @@ namespace fs = std::filesystem;
 
 namespace kunai {
 
+// aStr as an unsigned decimal, clamped to aMax. false if empty, not a number or with trailing chars
+static bool parseUnsigned(const std::string& aStr, uint64_t aMax, uint64_t& aoValue) {
+    if (aStr.empty() || !std::isdigit(static_cast<unsigned char>(aStr.front()))) {
+        return false;  // strtoull accepts spaces and signs
+    }
+    char* pEnd = nullptr;
+    errno = 0;
+    const auto value = std::strtoull(aStr.c_str(), &pEnd, 10);
+    if (*pEnd != '\0') {
+        return false;
+    }
+    aoValue = (errno == ERANGE || value > aMax) ? aMax : static_cast<uint64_t>(value);
+    return true;
+}
+
 bool App::init(int32_t argc, char** argv) {
     bool set_current_dir{false};
 #ifdef _MSC_VER
     set_current_dir = true;
 #endif
     ez::App app(argc, argv, set_current_dir);
+    // forwarded as is to the daemon
+    for (int32_t idx = 1; idx < argc; ++idx) {
+        m_rawArgs.emplace_back(argv[idx]);
+    }
+    return m_parseArgs(argc, argv);
+}
+
+bool App::m_parseArgs(int32_t argc, char** argv) {
     m_args = ez::Args(kunai_Label, "--help");
     m_args.addHeader("parse Ninja files and Find which executables to rebuild for changed file(s)");
 
     m_args.addPositional("build-dir").help("The build directory", "<build-dir>");
     m_args.addOptional("-r/--rebuild").help("Force the kunia database rebuild", {});
     m_args.addOptional("-t/--time").help("print the time perf of the command", {});
+    m_args.addOptional("--backend").delimiter(' ').help("query backend : sqlite, snapshot or closure. default is sqlite", "<backend>");
+    m_args.addOptional("--hash").delimiter(' ').help("change detection hash of the next rebuild : fast128 or sha1. default is fast128", "<algo>");
+    m_args.addOptional("--lock-timeout").delimiter(' ').help("max time waiting for the rebuild of another process, in seconds. default is 600", "<seconds>");
     m_args.addOptional("-se/--sources-exts").delimiter(' ').arrayUnlimited().help("set the sources exts. default is {.c,.cc,.cpp,.cxx,.inl}", "<sources-exts>");
     m_args.addOptional("-he/--headers-exts").delimiter(' ').arrayUnlimited().help("set the headers exts. default is {.h,.hh,.hpp,.hxx,.tpp,.inc}", "<headers-exts>");
     m_args.addOptional("-ie/--inputs-exts").delimiter(' ').arrayUnlimited().help("set the inputs exts. default is {.init,.log,.txt,.xml,.csv,.bin}", "<inputs-exts>");
@@ -34,13 +76,32 @@ bool App::init(int32_t argc, char** argv) {
     // command stats
     m_args.addCommand("stats").help("Get stats of the kunai database", {});
 
+    // command serve
+    m_args.addCommand("serve").help("Keep the graph loaded and answer the queries of the clients on kunai.sock", {});
+
+    // command watch
+    auto& cmd_watch = m_args.addCommand("watch").help("Watch the sources and headers, print the targets pointed by the edited files", {});
+    cmd_watch.addOptional("-b/--bins").help("Get binaries targets", {});
+    cmd_watch.addOptional("-l/--libs").help("Get libraries targets", {});
+    cmd_watch.addOptional("-s/--sources").help("Get sources targets", {});
+    cmd_watch.addOptional("-h/--headers").help("Get headers targets", {});
+    cmd_watch.addOptional("--match").delimiter(' ').help("match patterns for filtering targets, comma separated, re:<regex> for a regex (ex : --match test_*,re:_ut$). not case sensitive", "<patterns>");
+    cmd_watch.addOptional("--debounce").delimiter(' ').help("quiet time closing a burst of saves, in ms. default is 300", "<ms>");
+
+    // command hotspots
+    auto& cmd_hotspots = m_args.addCommand("hotspots").help("Rank the sources and headers by what a change of them rebuilds", {});
+    cmd_hotspots.addOptional("-s/--sources").help("Rank the sources", {});
+    cmd_hotspots.addOptional("-h/--headers").help("Rank the headers", {});
+    cmd_hotspots.addOptional("--sort").delimiter(' ').help("ranking key : fanin, objects, libs, bins, tests or cost. default is bins", "<key>");
+    cmd_hotspots.addOptional("--top").delimiter(' ').help("count of files printed. default is 20", "<count>");
+
     // command all
     auto& cmd_all = m_args.addCommand("all").help("Get all targets by type", {});
     cmd_all.addOptional("-b/--bins").help("Get binaries targets", {});
     cmd_all.addOptional("-l/--libs").help("Get libraries targets", {});
     cmd_all.addOptional("-s/--sources").help("Get sources targets", {});
     cmd_all.addOptional("-h/--headers").help("Get headers targets", {});
-    cmd_all.addOptional("--match").delimiter(' ').help("match pattern for filtering targets (ex : --match test_*). not case sensitive", "<pattern>");
+    cmd_all.addOptional("--match").delimiter(' ').help("match patterns for filtering targets, comma separated, re:<regex> for a regex (ex : --match test_*,re:_ut$). not case sensitive", "<patterns>");
 
     // command pointed
     auto& cmd_pointed = m_args.addCommand("pointed").help("Get targets pointed by modified files", {});
@@ -48,12 +109,60 @@ bool App::init(int32_t argc, char** argv) {
     cmd_pointed.addOptional("-l/--libs").help("Get libraries targets", {});
     cmd_pointed.addOptional("-s/--sources").help("Get sources targets", {});
     cmd_pointed.addOptional("-h/--headers").help("Get headers targets", {});
-    cmd_pointed.addOptional("--match").delimiter(' ').help("match pattern for filtering targets (ex : --match test_*). not case sensitive", "<pattern>");
+    cmd_pointed.addOptional("--match").delimiter(' ').help("match patterns for filtering targets, comma separated, re:<regex> for a regex (ex : --match test_*,re:_ut$). not case sensitive", "<patterns>");
+    cmd_pointed.addOptional("--suffix").help("match the source files by their longest path suffix (ex : git diff --name-only paths)", {});
+    cmd_pointed.addOptional("--source-root").delimiter(' ').help("root dir of the relative source files. makes the suffix matching exact", "<source-root>");
+    cmd_pointed.addOptional("--edges").delimiter(' ').help("comma separated kinds of links followed : explicit,implicit,order-only,deps,cmake or all. default is all but order-only", "<kinds>");
+    cmd_pointed.addOptional("--files-from").delimiter(' ').help("read the source files from a list file, one by line. - for stdin. same as @<list-file>", "<list-file>");
+    cmd_pointed.addOptional("--order")
+        .delimiter(' ')
+        .help("name, distance (fewest hops from the files first, streamed) or cost (cheapest last build first). default is name", "<order>");
     cmd_pointed.addPositional("source_files")
-        .help("The source file non case sensitive pattern. Can be a sub-string without wildcards", "<source-files>")
+        .help("The source file non case sensitive pattern. Can be a sub-string without wildcards. @<list-file> reads them from a list file, @- from stdin", "<source-files>")
+        .arrayUnlimited();
+
+    auto& cmd_rebuild = m_args.addCommand("rebuild-set").help("Get the fewest ninja targets building the outputs pointed by modified files", {});
+    cmd_rebuild.addOptional("-b/--bins").help("Cover the pointed binaries (default with libs)", {});
+    cmd_rebuild.addOptional("-l/--libs").help("Cover the pointed libraries (default with bins)", {});
+    cmd_rebuild.addOptional("-o/--objects").help("Add the pointed objects not built by the selected outputs, to precompile them", {});
+    cmd_rebuild.addOptional("-n/--ninja").help("Print the ninja invocation instead of the targets", {});
+    cmd_rebuild.addOptional("--match").delimiter(' ').help("match patterns of the binaries and libraries covered, comma separated, re:<regex> for a regex (ex : --match test_*). not case sensitive", "<patterns>");
+    cmd_rebuild.addOptional("--suffix").help("match the source files by their longest path suffix (ex : git diff --name-only paths)", {});
+    cmd_rebuild.addOptional("--source-root").delimiter(' ').help("root dir of the relative source files. makes the suffix matching exact", "<source-root>");
+    cmd_rebuild.addOptional("--edges").delimiter(' ').help("comma separated kinds of links followed : explicit,implicit,order-only,deps,cmake or all. default is all but order-only", "<kinds>");
+    cmd_rebuild.addOptional("--files-from").delimiter(' ').help("read the source files from a list file, one by line. - for stdin. same as @<list-file>", "<list-file>");
+    cmd_rebuild.addPositional("source_files")
+        .help("The source file non case sensitive pattern. Can be a sub-string without wildcards. @<list-file> reads them from a list file, @- from stdin", "<source-files>")
         .arrayUnlimited();
 
-    if (m_args.parse(argc, argv)) {
+    auto& cmd_batch = m_args.addCommand("batch").help("Answer the ndjson queries of stdin, one result line by query, with the graph loaded once", {});
+    cmd_batch.addOptional("-b/--bins").help("Get binaries targets, if a query has no types", {});
+    cmd_batch.addOptional("-l/--libs").help("Get libraries targets, if a query has no types", {});
+    cmd_batch.addOptional("-s/--sources").help("Get sources targets, if a query has no types", {});
+    cmd_batch.addOptional("-h/--headers").help("Get headers targets, if a query has no types", {});
+    cmd_batch.addOptional("--match").delimiter(' ').help("match patterns for filtering targets, if a query has no match. comma separated, re:<regex> for a regex. not case sensitive", "<patterns>");
+    cmd_batch.addOptional("--suffix").help("match the source files by their longest path suffix (ex : git diff --name-only paths)", {});
+    cmd_batch.addOptional("--source-root").delimiter(' ').help("root dir of the relative source files. makes the suffix matching exact", "<source-root>");
+    cmd_batch.addOptional("--edges").delimiter(' ').help("kinds of links followed, if a query has no edges. default is all but order-only", "<kinds>");
+
+    // command fingerprint
+    auto& cmd_fingerprint = m_args.addCommand("fingerprint").help("Get a digest of the sources, headers, libraries and inputs of each binary", {});
+    cmd_fingerprint.addOptional("--match").delimiter(' ').help("match patterns of the binaries, comma separated, re:<regex> for a regex (ex : --match test_*). not case sensitive", "<patterns>");
+    cmd_fingerprint.addOptional("--edges").delimiter(' ').help("comma separated kinds of links followed : explicit,implicit,order-only,deps,cmake or all. default is all but order-only", "<kinds>");
+
+    // ezArgs requires the positional of a command : --files-from <list-file> is given to it as @<list-file>
+    std::vector<std::string> args(argv, argv + argc);
+    for (size_t idx = 1U; idx + 1U < args.size(); ++idx) {
+        if (args[idx] == "--files-from") {
+            args[idx + 1U] = "@" + args[idx + 1U];
+            args.erase(args.begin() + static_cast<std::ptrdiff_t>(idx));
+        }
+    }
+    std::vector<char*> argvs;
+    for (auto& arg : args) {
+        argvs.push_back(&arg[0]);
+    }
+    if (m_args.parse(static_cast<int32_t>(argvs.size()), argvs.data())) {
         // build dir
         auto buildDir = m_args.getValue<std::string>("build-dir");
         if (buildDir == ".") {
@@ -64,6 +173,46 @@ bool App::init(int32_t argc, char** argv) {
         }
         m_buildDir = buildDir;
 
+        // backend
+        const auto backend = m_args.getValue<std::string>("backend");
+        if (backend == "snapshot") {
+            m_backend = datas::Backend::SNAPSHOT;
+        } else if (backend == "closure") {
+            m_backend = datas::Backend::CLOSURE;
+        } else if (!backend.empty() && backend != "sqlite") {
+            std::cerr << "Unknown backend " << backend << ", expected sqlite, snapshot or closure" << std::endl;
+            return false;
+        }
+
+        // hash
+        const auto hash = m_args.getValue<std::string>("hash");
+        if (!hash.empty() && !utils::FileHash::parseName(hash, m_hashAlgo)) {
+            std::cerr << "Unknown hash " << hash << ", expected fast128 or sha1" << std::endl;
+            return false;
+        }
+
+        // lock timeout, in ms it must fit in 32 bits
+        const auto lockTimeout = m_args.getValue<std::string>("lock-timeout");
+        if (!lockTimeout.empty()) {
+            uint64_t seconds{};
+            if (!parseUnsigned(lockTimeout, UINT32_MAX / 1000U, seconds)) {
+                std::cerr << "Invalid lock timeout " << lockTimeout << ", expected a count of seconds" << std::endl;
+                return false;
+            }
+            m_lockTimeoutMs = static_cast<uint32_t>(seconds * 1000U);
+        }
+
+        // match, compiled once for all the targets
+        const auto match = m_args.getValue<std::string>("match");
+        if (!match.empty()) {
+            auto matcher = utils::PathMatcher::create(match);
+            if (matcher.first == nullptr) {
+                std::cerr << matcher.second << std::endl;
+                return false;
+            }
+            mp_matcher = std::move(matcher.first);
+        }
+
         return true;
     } else {
         m_args.printErrors(" - ");
@@ -81,22 +230,29 @@ int32_t App::run() {
         {
             ez::time::ScopedTimer t(timing);
 
-            auto tmp_pLoader = Loader::create(m_buildDir, m_args.isPresent("rebuild"));
-            if (tmp_pLoader.first == nullptr) {
-                std::cerr << "Error loading build dir " << m_buildDir << " : " << tmp_pLoader.second << std::endl;
-                return false;
-            }
-            mp_loader = std::move(tmp_pLoader.first);
+            if (!m_runOnDaemon(m_lockTimeoutMs, ret)) {
+                auto tmp_pLoader = Loader::create(m_buildDir, m_args.isPresent("rebuild"), m_backend, m_lockTimeoutMs, m_hashAlgo);
+                if (tmp_pLoader.first == nullptr) {
+                    std::cerr << "Error loading build dir " << m_buildDir << " : " << tmp_pLoader.second << std::endl;
+                    return EXIT_FAILURE;
+                }
+                mp_loader = std::move(tmp_pLoader.first);
 
-            if (m_args.isCommand("stats")) {
-                ret = m_cmdStats();
-            } else if (m_args.isCommand("all")) {
-                ret = m_cmdAllTargetsByType();
-            } else if (m_args.isCommand("pointed")) {
-                ret = m_cmdPointedTargetsByType();
+                if (m_args.isCommand("serve")) {
+                    ret = m_cmdServe(m_lockTimeoutMs);
+                } else if (m_args.isCommand("watch")) {
+                    ret = m_cmdWatch();
+                } else if (m_args.isCommand("batch")) {
+                    ret = m_cmdBatch();
+                } else {
+                    ret = m_runCommand();
+                }
             }
         }
         if (m_args.isPresent("time")) {
+            if (mp_loader != nullptr && mp_loader->getLockWaitedMs() > 0.0) {
+                std::cout << "[waited " << mp_loader->getLockWaitedMs() << " ms for the rebuild of another process]" << std::endl;
+            }
             std::cout << "[retrieved in " << timing << " ms]" << std::endl;
         }
     } catch (const fs::filesystem_error& e) {
@@ -110,12 +266,376 @@ int32_t App::run() {
 void App::unit() {
 }
 
+int32_t App::m_runCommand() const {
+    int32_t ret{EXIT_FAILURE};
+    if (m_args.isCommand("stats")) {
+        ret = m_cmdStats();
+    } else if (m_args.isCommand("hotspots")) {
+        ret = m_cmdHotspots();
+    } else if (m_args.isCommand("all")) {
+        ret = m_cmdAllTargetsByType();
+    } else if (m_args.isCommand("pointed")) {
+        ret = m_cmdPointedTargetsByType();
+    } else if (m_args.isCommand("rebuild-set")) {
+        ret = m_cmdRebuildSet();
+    } else if (m_args.isCommand("fingerprint")) {
+        ret = m_cmdFingerprint();
+    }
+    return ret;
+}
+
+namespace {
+constexpr uint32_t REQUEST_TIMEOUT_MS{5000U};     // a client not sending its request line within it is dropped by the daemon
+constexpr uint32_t QUERY_MARGIN_MS{60000U};       // added to the lock timeout for the answer of the daemon
+constexpr const char* RUN_LOCALLY{"local"};       // response of the daemon to a request it doesn't serve as asked
+constexpr int32_t EXIT_NOTHING_TO_REBUILD{2};     // rebuild-set with an empty set, told apart from the errors
+}  // namespace
+
+// request  : <client cwd>\t<arg>\t<arg>...\n, the args of the client command line
+// response : <exit code>\t<stdout size>\t<stderr size>\n<stdout><stderr>
+//            or RUN_LOCALLY\n if the client must run the command itself (ex : another --backend)
+bool App::m_runOnDaemon(uint32_t aLockTimeoutMs, int32_t& aoRet) const {
+    const bool isQuery = m_args.isCommand("stats") || m_args.isCommand("hotspots") || m_args.isCommand("all") || m_args.isCommand("pointed") ||
+        m_args.isCommand("rebuild-set") || m_args.isCommand("fingerprint");
+    if (!isQuery || m_args.isPresent("rebuild")) {
+        return false;
+    }
+    if (m_args.isCommand("pointed") || m_args.isCommand("rebuild-set")) {
+        const auto files = m_args.getArrayValues("source_files");
+        if (std::any_of(files.begin(), files.end(), [](const std::string& aFile) { return !aFile.empty() && (aFile[0] == '@'); })) {
+            return false;  // the list files are read by the client, the daemon reads neither its stdin nor files on its behalf
+        }
+        if (m_args.isCommand("pointed") && (m_args.getValue<std::string>("order") == "distance")) {
+            return false;  // the daemon answers at once, a local run streams the targets
+        }
+    }
+    const auto socketPath = m_buildDir / datas::KUNAI_SOCKET_NAME;
+    std::error_code ec;
+    if (!fs::exists(socketPath, ec)) {
+        return false;
+    }
+    std::string request = fs::current_path().string();
+    for (const auto& arg : m_rawArgs) {
+        if (arg.find_first_of("\t\n") != std::string::npos) {
+            return false;  // not representable, answered locally
+        }
+        request += "\t" + arg;
+    }
+    request += "\n";
+    // a daemon killed without cleanup leaves its socket, the query is then answered locally
+    auto tmp_pSocket = utils::LocalSocket::create(socketPath);
+    if (tmp_pSocket.first == nullptr) {
+        return false;
+    }
+    // the daemon may wait for a rebuild before answering, a stuck daemon gives a local run
+    tmp_pSocket.first->setTimeout(aLockTimeoutMs + QUERY_MARGIN_MS);
+    std::string header;
+    if (!tmp_pSocket.first->writeAll(request) || !tmp_pSocket.first->readLine(header) || (header == RUN_LOCALLY)) {
+        return false;
+    }
+    int32_t ret{EXIT_FAILURE};
+    size_t outSize{};
+    size_t errSize{};
+    std::stringstream ss(header);
+    std::string out;
+    std::string err;
+    if (!(ss >> ret >> outSize >> errSize)              //
+        || !tmp_pSocket.first->readExact(outSize, out)  //
+        || !tmp_pSocket.first->readExact(errSize, err)) {
+        return false;
+    }
+    std::cout << out << std::flush;
+    std::cerr << err << std::flush;
+    aoRet = ret;
+    return true;
+}
+
+namespace {
+std::atomic<bool> s_stopRequested{false};  // serve and watch loops
+void onStopSignal(int) {
+    s_stopRequested = true;
+}
+int64_t getNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}  // namespace
+
+int32_t App::m_cmdServe(uint32_t aLockTimeoutMs) {
+    m_buildDir = fs::absolute(m_buildDir);  // the requests change the current dir
+    auto tmp_pServer = utils::LocalServer::create(m_buildDir / datas::KUNAI_SOCKET_NAME);
+    if (tmp_pServer.first == nullptr) {
+        std::cerr << "Cannot serve " << m_buildDir << " : " << tmp_pServer.second << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+#ifdef SIGPIPE
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    // the graph is reloaded once the build files stay quiet, ninja writes .ninja_deps during the whole build
+    std::atomic<bool> changed{false};
+    std::atomic<int64_t> lastChangeMs{0};
+    ez::file::Watcher watcher;
+    watcher.setCallback([&changed, &lastChangeMs](const std::set<ez::file::Watcher::PathResult>&) {
+        lastChangeMs = getNowMs();
+        changed = true;
+    });
+    watcher.watchFile(m_buildDir.string(), "build.ninja");
+    watcher.watchFile(m_buildDir.string(), ".ninja_deps");
+    if (!watcher.start()) {
+        std::cerr << "File watching not available, the graph is only reloaded by the requests" << std::endl;
+    }
+    std::cout << "serving " << m_buildDir.string() << " on " << datas::KUNAI_SOCKET_NAME << std::endl;
+
+    auto reload = [this, aLockTimeoutMs]() {
+        auto tmp_pLoader = Loader::create(m_buildDir, false, m_backend, aLockTimeoutMs, m_hashAlgo);
+        if (tmp_pLoader.first == nullptr) {
+            std::cerr << "Reload failed, the previous graph is kept : " << tmp_pLoader.second << std::endl;
+            return;
+        }
+        mp_loader = std::move(tmp_pLoader.first);
+    };
+
+    constexpr int64_t quietDelayMs{1000};
+    while (!s_stopRequested) {
+        auto pClient = tmp_pServer.first->accept(200U);
+        // a request is answered on a fresh graph : the watcher events come late, the stat stamps are checked.
+        // an idle server reloads once the files are quiet
+        if ((pClient != nullptr && !mp_loader->isFresh()) || (changed && (getNowMs() - lastChangeMs) >= quietDelayMs)) {
+            changed = false;
+            reload();
+        }
+        if (pClient != nullptr) {
+            m_serveClient(*pClient);
+        }
+    }
+    watcher.stop();
+    return EXIT_SUCCESS;
+}
+
+int32_t App::m_cmdWatch() {
+    auto typeMask = m_getTypeMask();
+    if (typeMask == 0U) {
+        typeMask = datas::toMask(datas::TargetType::BINARY);
+    }
+    uint64_t debounceMs{300U};
+    const auto debounce = m_args.getValue<std::string>("debounce");
+    if (!debounce.empty() && !parseUnsigned(debounce, 3600000U, debounceMs)) {
+        std::cerr << "Invalid debounce " << debounce << ", expected a count of ms" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // absolute path of the watched files -> graph path. one inotify watch by directory.
+    // rebuilt with the graph, ninja rewrites .ninja_deps at each build : new includes, new sources
+    const auto buildDir = fs::absolute(m_buildDir);
+    const auto buildNinjaPath = (buildDir / "build.ninja").string();
+    const auto ninjaDepsPath = (buildDir / ".ninja_deps").string();
+    std::map<std::string, std::string> graphPathByFile;
+    std::set<std::string> dirs;
+    auto collectFiles = [&]() {
+        graphPathByFile.clear();
+        dirs.clear();
+        const auto files = m_mergeTargets(mp_loader->getAllTargets(datas::toMask(datas::TargetType::SOURCE) | datas::toMask(datas::TargetType::HEADER)));
+        for (const auto& file : files) {
+            fs::path filePath(file);
+            if (filePath.is_relative()) {
+                filePath = buildDir / filePath;
+            }
+            filePath = filePath.lexically_normal();
+            const auto dir = filePath.parent_path().string();
+            graphPathByFile[dir + "/" + filePath.filename().string()] = file;
+            dirs.insert(dir);
+        }
+    };
+
+    std::mutex pendingMutex;
+    std::set<std::string> pendingFiles;  // graph paths saved since the last print
+    std::atomic<int64_t> lastChangeMs{0};
+    std::atomic<bool> buildChanged{false};
+    std::atomic<int64_t> lastBuildChangeMs{0};
+    auto onChanges = [&](const std::set<ez::file::Watcher::PathResult>& aResults) {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        for (const auto& result : aResults) {
+            const auto path = result.rootPath + "/" + result.newPath;
+            if ((path == buildNinjaPath) || (path == ninjaDepsPath)) {
+                lastBuildChangeMs = getNowMs();
+                buildChanged = true;
+                continue;
+            }
+            const auto it = graphPathByFile.find(path);
+            if (it != graphPathByFile.end()) {
+                pendingFiles.insert(it->second);
+                lastChangeMs = getNowMs();
+            }
+        }
+    };
+    std::unique_ptr<ez::file::Watcher> pWatcher;
+    size_t watchedDirs{};
+    auto startWatcher = [&]() {
+        pWatcher = std::make_unique<ez::file::Watcher>();
+        pWatcher->setCallback(onChanges);
+        pWatcher->watchFile(buildDir.string(), "build.ninja");
+        pWatcher->watchFile(buildDir.string(), ".ninja_deps");
+        watchedDirs = 0U;
+        for (const auto& dir : dirs) {
+            if (fs::is_directory(dir) && pWatcher->watchDirectory(dir)) {
+                ++watchedDirs;
+            }
+        }
+        return pWatcher->start();
+    };
+    collectFiles();
+    if (!startWatcher()) {
+        std::cerr << "File watching is not available" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+    std::cout << "watching " << graphPathByFile.size() << " files in " << watchedDirs << " dirs" << std::endl;
+
+    // each edited file is queried once, alone : a save of a hot header doesn't query the others again.
+    // the printed set is the union of the targets of all the files edited since the start
+    datas::SeedOptions seedOptions;
+    seedOptions.buildDir = buildDir;
+    seedOptions.match = datas::PathMatch::SUFFIX;
+    std::map<std::string, std::set<std::string>> targetsByFile;  // by edited file, cleared by a reload
+    std::set<std::string> editedFiles;
+    constexpr int64_t quietDelayMs{1000};
+    while (!s_stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::set<std::string> burst;
+        bool reloaded{false};
+        if (buildChanged && (getNowMs() - lastBuildChangeMs) >= quietDelayMs) {
+            // the graph is reloaded once the build files stay quiet, like the serve daemon
+            buildChanged = false;
+            auto tmp_pLoader = Loader::create(m_buildDir, false, m_backend, m_lockTimeoutMs, m_hashAlgo);
+            if (tmp_pLoader.first == nullptr) {
+                std::cerr << "Reload failed, the previous graph is kept : " << tmp_pLoader.second << std::endl;
+            } else {
+                pWatcher->stop();
+                mp_loader = std::move(tmp_pLoader.first);
+                {
+                    std::lock_guard<std::mutex> lock(pendingMutex);
+                    collectFiles();
+                }
+                if (!startWatcher()) {
+                    std::cerr << "File watching is not available" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                targetsByFile.clear();
+                reloaded = !editedFiles.empty();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            if (!reloaded && (pendingFiles.empty() || (getNowMs() - lastChangeMs) < static_cast<int64_t>(debounceMs))) {
+                continue;
+            }
+            if (!pendingFiles.empty() && (getNowMs() - lastChangeMs) >= static_cast<int64_t>(debounceMs)) {
+                burst.swap(pendingFiles);
+            }
+        }
+        editedFiles.insert(burst.begin(), burst.end());
+        std::set<std::string> targets;
+        for (const auto& file : editedFiles) {
+            auto it = targetsByFile.find(file);
+            if (it == targetsByFile.end()) {
+                it = targetsByFile.emplace(file, m_mergeTargets(mp_loader->getPointedTargets({file}, typeMask, seedOptions, {}, mp_matcher.get()))).first;
+            }
+            targets.insert(it->second.begin(), it->second.end());
+        }
+        if (burst.empty()) {
+            std::cout << "--- graph reloaded\n";
+        } else {
+            std::cout << "--- edited :";
+            for (const auto& file : burst) {
+                std::cout << " " << file;
+            }
+            std::cout << "\n";
+        }
+        m_printTargets(targets);
+        std::cout << std::flush;
+    }
+    pWatcher->stop();
+    return EXIT_SUCCESS;
+}
+
+void App::m_serveClient(utils::LocalSocket& arClient) const {
+    // the daemon serves one client at a time, a silent one is dropped
+    arClient.setTimeout(REQUEST_TIMEOUT_MS);
+    std::string line;
+    if (!arClient.readLine(line)) {
+        return;
+    }
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, '\t')) {
+        fields.push_back(field);
+    }
+    if (fields.empty()) {
+        return;
+    }
+    std::vector<char*> argv;
+    std::string programName{"kunai"};
+    argv.push_back(&programName[0]);
+    for (size_t idx = 1U; idx < fields.size(); ++idx) {
+        argv.push_back(&fields[idx][0]);
+    }
+
+    // the command writes on std::cout and std::cerr, both are captured for the client
+    std::stringstream out;
+    std::stringstream err;
+    auto* pOldOut = std::cout.rdbuf(out.rdbuf());
+    auto* pOldErr = std::cerr.rdbuf(err.rdbuf());
+    int32_t ret{EXIT_FAILURE};
+    bool runLocally{false};
+    std::error_code ec;
+    const auto serverCwd = fs::current_path(ec);
+    try {
+        fs::current_path(fields[0], ec);  // relative paths of the client, ex : --source-root
+        App request;
+        if (ec) {
+            runLocally = true;  // they would be resolved against the dir of the daemon
+        } else if (request.m_parseArgs(static_cast<int32_t>(argv.size()), argv.data())) {
+            // the graph of the daemon is loaded with its own backend and hash, the client runs locally with others
+            if ((request.m_args.isPresent("backend") && (request.m_backend != m_backend)) ||  //
+                (request.m_args.isPresent("hash") && (request.m_hashAlgo != m_hashAlgo))) {
+                runLocally = true;
+            } else {
+                request.m_buildDir = m_buildDir;
+                request.mp_loader = mp_loader;
+                ret = request.m_runCommand();
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Err : " << e.what() << std::endl;
+    }
+    fs::current_path(serverCwd, ec);
+    std::cout.rdbuf(pOldOut);
+    std::cerr.rdbuf(pOldErr);
+    if (runLocally) {
+        arClient.writeAll(std::string(RUN_LOCALLY) + "\n");
+        return;
+    }
+
+    const auto outStr = out.str();
+    const auto errStr = err.str();
+    arClient.writeAll(std::to_string(ret) + "\t" + std::to_string(outStr.size()) + "\t" + std::to_string(errStr.size()) + "\n" + outStr + errStr);
+}
+
 int32_t App::m_cmdStats() const {
     const auto stats = mp_loader->getStats();
     {
         ez::TableFormatter tbl({"Stats", ""});
         tbl.addRow({"Database", (m_buildDir / datas::KUNAI_DB_NAME).string()});
         tbl.addRow({"Dependencies", ez::str::toStr(stats.counters.deps)});
+        tbl.addRow({" - explicit", ez::str::toStr(stats.counters.explicitDeps)});
+        tbl.addRow({" - implicit", ez::str::toStr(stats.counters.implicitDeps)});
+        tbl.addRow({" - order-only", ez::str::toStr(stats.counters.orderOnlyDeps)});
+        tbl.addRow({" - deps log", ez::str::toStr(stats.counters.depsLogDeps)});
+        tbl.addRow({" - cmake", ez::str::toStr(stats.counters.cmakeDeps)});
         tbl.addRow({"Sources", ez::str::toStr(stats.counters.sources)});
         tbl.addRow({"Headers", ez::str::toStr(stats.counters.headers)});
         tbl.addRow({"Objects", ez::str::toStr(stats.counters.objects)});
@@ -125,70 +645,492 @@ int32_t App::m_cmdStats() const {
         tbl.print("", std::cout);
     }
     {
-        ez::TableFormatter tbl({"Perfos", "Last measures"});
-        tbl.addRow({"db filling", ez::str::toStr(stats.timings.dbFilling) + " ms"});
-        tbl.addRow({"db loading", ez::str::toStr(stats.timings.dbLoading) + " ms"});
-        tbl.addRow({"last query", ez::str::toStr(stats.timings.query) + " ms"});
+        auto addRow = [](ez::TableFormatter& arTbl, const std::string& aName, const DataBase::Stats::Measure& aMeasure) {
+            arTbl.addRow({aName, ez::str::toStr(aMeasure.last) + " ms", ez::str::toStr(aMeasure.mean) + " ms", ez::str::toStr(aMeasure.count)});
+        };
+        ez::TableFormatter tbl({"Perfos", "Last", "Mean", "Count"});
+        addRow(tbl, "db filling", stats.timings.dbFilling);
+        addRow(tbl, "db loading", stats.timings.dbLoading);
+        addRow(tbl, "query", stats.timings.query);
+        tbl.print("", std::cout);
+    }
+    if (stats.phases.parsing.wall.count > 0U) {
+        auto addRow = [](ez::TableFormatter& arTbl, const std::string& aName, const DataBase::Stats::Phase& aPhase) {
+            arTbl.addRow({aName, ez::str::toStr(aPhase.wall.last) + " ms", ez::str::toStr(aPhase.cpu.last) + " ms"});
+        };
+        ez::TableFormatter tbl({"Last rebuild", "Wall", "Cpu"});
+        addRow(tbl, "parse build.ninja", stats.phases.parseBuild);
+        addRow(tbl, "parse .ninja_deps", stats.phases.parseDeps);
+        addRow(tbl, "parse cmake reply", stats.phases.parseCMake);
+        tbl.addRow({"parsing (concurrent)", ez::str::toStr(stats.phases.parsing.wall.last) + " ms", ""});
+        addRow(tbl, "writing", stats.phases.writing);
+        tbl.print("", std::cout);
+    }
+    if (stats.queue.batches.count > 0U) {
+        ez::TableFormatter tbl({"Writer queue", "Last"});
+        tbl.addRow({"batches", ez::str::toStr(stats.queue.batches.last)});
+        tbl.addRow({"max depth", ez::str::toStr(stats.queue.maxDepth.last)});
+        tbl.addRow({"mean depth", ez::str::toStr(stats.queue.meanDepth.last)});
+        tbl.addRow({"parsers stall", ez::str::toStr(stats.queue.parserStall.last) + " ms"});
+        tbl.addRow({"writer wait", ez::str::toStr(stats.queue.writerWait.last) + " ms"});
         tbl.print("", std::cout);
     }
     return EXIT_SUCCESS;
 }
 
-int32_t App::m_cmdAllTargetsByType() const {
-    std::set<std::string> targets;
+int32_t App::m_cmdHotspots() const {
+    using Entry = graph::Hotspots::Entry;
+    static const std::map<std::string, double (*)(const Entry&)> keys{
+        {"fanin", [](const Entry& e) { return static_cast<double>(e.fanIn); }},
+        {"objects", [](const Entry& e) { return static_cast<double>(e.objects); }},
+        {"libs", [](const Entry& e) { return static_cast<double>(e.libraries); }},
+        {"bins", [](const Entry& e) { return static_cast<double>(e.binaries); }},
+        {"tests", [](const Entry& e) { return static_cast<double>(e.tests); }},
+        {"cost", [](const Entry& e) { return e.cost; }},
+    };
+    auto sort = m_args.getValue<std::string>("sort");
+    if (sort.empty()) {
+        sort = "bins";
+    }
+    const auto itKey = keys.find(sort);
+    if (itKey == keys.end()) {
+        std::cerr << "Unknown sort key " << sort << ", expected fanin, objects, libs, bins, tests or cost" << std::endl;
+        return EXIT_FAILURE;
+    }
+    uint64_t top = 20U;
+    const auto topStr = m_args.getValue<std::string>("top");
+    if (!topStr.empty() && !parseUnsigned(topStr, SIZE_MAX, top)) {
+        std::cerr << "Invalid top " << topStr << ", expected a count of entries" << std::endl;
+        return EXIT_FAILURE;
+    }
+    datas::TargetTypeMask typeMask = m_getTypeMask();
+    if (typeMask == 0U) {
+        typeMask = datas::toMask(datas::TargetType::SOURCE) | datas::toMask(datas::TargetType::HEADER);
+    }
+
+    bool hasCosts{false};
+    auto entries = mp_loader->getHotspots(typeMask, datas::DEFAULT_EDGE_KINDS, hasCosts);
+    if (entries.empty() && !mp_loader->getError().empty()) {
+        std::cerr << mp_loader->getError() << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto getKey = itKey->second;
+    std::stable_sort(entries.begin(), entries.end(), [getKey](const Entry& a, const Entry& b) {
+        const auto ka = getKey(a);
+        const auto kb = getKey(b);
+        if (ka != kb) {
+            return ka > kb;
+        }
+        if (a.binaries != b.binaries) {
+            return a.binaries > b.binaries;
+        }
+        return a.path < b.path;
+    });
+
+    ez::TableFormatter tbl({"File", "Fan-in", "Objects", "Libraries", "Binaries", "Tests", "Cost"});
+    for (size_t idx = 0U; (idx < entries.size()) && (idx < top); ++idx) {
+        const auto& entry = entries[idx];
+        tbl.addRow(
+            {std::string(entry.path),
+             ez::str::toStr(entry.fanIn),
+             ez::str::toStr(entry.objects),
+             ez::str::toStr(entry.libraries),
+             ez::str::toStr(entry.binaries),
+             ez::str::toStr(entry.tests),
+             hasCosts ? ez::str::toStr(entry.cost) + " ms" : std::string("-")});
+    }
+    tbl.print("", std::cout);
+    return EXIT_SUCCESS;
+}
+
+datas::TargetTypeMask App::m_getTypeMask() const {
+    datas::TargetTypeMask ret{0U};
     if (m_args.isPresent("sources")) {
-        const auto sources = mp_loader->getAllTargetsByType(datas::TargetType::SOURCE);
-        targets.insert(sources.begin(), sources.end());
+        ret |= datas::toMask(datas::TargetType::SOURCE);
     }
     if (m_args.isPresent("headers")) {
-        const auto headers = mp_loader->getAllTargetsByType(datas::TargetType::HEADER);
-        targets.insert(headers.begin(), headers.end());
+        ret |= datas::toMask(datas::TargetType::HEADER);
     }
     if (m_args.isPresent("libs")) {
-        const auto libs = mp_loader->getAllTargetsByType(datas::TargetType::LIBRARY);
-        targets.insert(libs.begin(), libs.end());
+        ret |= datas::toMask(datas::TargetType::LIBRARY);
     }
     if (m_args.isPresent("bins")) {
-        const auto bins = mp_loader->getAllTargetsByType(datas::TargetType::BINARY);
-        targets.insert(bins.begin(), bins.end());
+        ret |= datas::toMask(datas::TargetType::BINARY);
+    }
+    return ret;
+}
+
+int32_t App::m_cmdAllTargetsByType() const {
+    const auto typeMask = m_getTypeMask();
+    if (typeMask == 0U) {
+        return m_printTargets({});
+    }
+    const auto targets = m_mergeTargets(mp_loader->getAllTargets(typeMask, mp_matcher.get()));
+    if (targets.empty()) {
+        return m_getNoTargetCode([this, typeMask]() { return mp_loader->getAllTargets(typeMask); });
     }
     return m_printTargets(targets);
 }
 
 int32_t App::m_cmdPointedTargetsByType() const {
-    const auto files = m_args.getArrayValues("source_files");
-    std::set<std::string> targets;
-    if (m_args.isPresent("sources")) {
-        const auto sources = mp_loader->getPointedTargetsByType(files, datas::TargetType::SOURCE);
-        targets.insert(sources.begin(), sources.end());
+    std::vector<std::string> files;
+    std::string error;
+    if (!m_expandFileArgs(m_args.getArrayValues("source_files"), files, error)) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
     }
-    if (m_args.isPresent("headers")) {
-        const auto headers = mp_loader->getPointedTargetsByType(files, datas::TargetType::HEADER);
-        targets.insert(headers.begin(), headers.end());
+    datas::SeedOptions seedOptions;
+    datas::TraversalOptions traversalOptions;
+    if (!m_getQueryOptions(seedOptions, traversalOptions)) {
+        return EXIT_FAILURE;
     }
-    if (m_args.isPresent("libs")) {
-        const auto libs = mp_loader->getPointedTargetsByType(files, datas::TargetType::LIBRARY);
-        targets.insert(libs.begin(), libs.end());
+    const auto order = m_args.getValue<std::string>("order");
+    datas::TargetOrder targetOrder{datas::TargetOrder::NAME};
+    if (order == "distance") {
+        targetOrder = datas::TargetOrder::DISTANCE;
+    } else if (order == "cost") {
+        targetOrder = datas::TargetOrder::COST;
+    } else if (!order.empty() && order != "name") {
+        std::cerr << "Unknown order " << order << ", expected name, distance or cost" << std::endl;
+        return EXIT_FAILURE;
     }
-    if (m_args.isPresent("bins")) {
-        const auto bins = mp_loader->getPointedTargetsByType(files, datas::TargetType::BINARY);
-        targets.insert(bins.begin(), bins.end());
+    const auto typeMask = m_getTypeMask();
+    if (typeMask == 0U) {
+        return m_printTargets({});
     }
-    return m_printTargets(targets);
+    auto getUnmatched = [&]() { return mp_loader->getPointedTargets(files, typeMask, seedOptions, traversalOptions); };
+    if (targetOrder == datas::TargetOrder::NAME) {
+        const auto targets = m_mergeTargets(mp_loader->getPointedTargets(files, typeMask, seedOptions, traversalOptions, mp_matcher.get()));
+        return targets.empty() ? m_getNoTargetCode(getUnmatched) : m_printTargets(targets);
+    }
+    // printed as soon as they are ordered, the runner can start the first targets
+    bool found{false};
+    const bool done = mp_loader->getPointedTargetsOrdered(
+        files, typeMask, seedOptions, traversalOptions, mp_matcher.get(), targetOrder, [&found](const std::vector<std::string_view>& aTargets) {
+            for (const auto& target : aTargets) {
+                std::cout << target << "\n";
+            }
+            std::cout << std::flush;
+            found = found || !aTargets.empty();
+        });
+    if (!done) {
+        std::cerr << mp_loader->getError() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return found ? EXIT_SUCCESS : m_getNoTargetCode(getUnmatched);
+}
+
+int32_t App::m_cmdRebuildSet() const {
+    std::vector<std::string> files;
+    std::string error;
+    if (!m_expandFileArgs(m_args.getArrayValues("source_files"), files, error)) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    datas::SeedOptions seedOptions;
+    datas::TraversalOptions traversalOptions;
+    if (!m_getQueryOptions(seedOptions, traversalOptions)) {
+        return EXIT_FAILURE;
+    }
+    const auto outputsMask = datas::toMask(datas::TargetType::LIBRARY) | datas::toMask(datas::TargetType::BINARY);
+    auto typeMask = m_getTypeMask() & outputsMask;
+    if (typeMask == 0U) {
+        typeMask = outputsMask;
+    }
+    const bool withObjects = m_args.isPresent("objects");
+    if (withObjects) {
+        typeMask |= datas::toMask(datas::TargetType::OBJECT);
+    }
+
+    // the pattern selects the binaries and libraries, the objects are the ones they don't build
+    std::vector<std::string> outputs;
+    for (const auto& entry : mp_loader->getPointedTargets(files, typeMask, seedOptions, traversalOptions)) {
+        for (const auto& path : entry.second) {
+            if ((entry.first == datas::TargetType::OBJECT) || (mp_matcher == nullptr) || mp_matcher->isMatching(path)) {
+                outputs.push_back(path);
+            }
+        }
+    }
+    auto targets = mp_loader->getRebuildSet(outputs);
+    if (targets.empty()) {
+        if (!mp_loader->getError().empty()) {
+            std::cerr << mp_loader->getError() << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cerr << "Nothing to rebuild" << std::endl;
+        return EXIT_NOTHING_TO_REBUILD;  // an empty ninja command line would build the default targets
+    }
+    std::sort(targets.begin(), targets.end());
+    if (m_args.isPresent("ninja")) {
+        std::cout << "ninja -C " << m_quoteShellArg(fs::absolute(m_buildDir).string());
+        for (const auto& target : targets) {
+            std::cout << " \\\n    " << m_quoteShellArg(target);
+        }
+        std::cout << "\n";
+    } else {
+        for (const auto& target : targets) {
+            std::cout << target << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+std::string App::m_quoteShellArg(const std::string& aArg) {
+    if (aArg.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-+=./:@%,") == std::string::npos) {
+        return aArg;
+    }
+    std::string ret{"'"};
+    for (const auto c : aArg) {
+        if (c == '\'') {
+            ret += "'\\''";
+        } else {
+            ret += c;
+        }
+    }
+    return ret + "'";
+}
+
+int32_t App::m_cmdFingerprint() const {
+    datas::SeedOptions seedOptions;
+    datas::TraversalOptions traversalOptions;
+    if (!m_getQueryOptions(seedOptions, traversalOptions)) {
+        return EXIT_FAILURE;
+    }
+    auto entries = mp_loader->getFingerprints(traversalOptions.edgeKinds, mp_matcher.get());
+    if (entries.empty()) {
+        if (!mp_loader->getError().empty()) {
+            std::cerr << mp_loader->getError() << std::endl;
+        }
+        return EXIT_FAILURE;
+    }
+    std::sort(entries.begin(), entries.end(), [](const graph::Fingerprint::Entry& a, const graph::Fingerprint::Entry& b) {  //
+        return a.path < b.path;
+    });
+    for (const auto& entry : entries) {
+        std::cout << entry.digest << " " << entry.path << "\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+// one query by line : {"id":..,"files":[..],"types":"bl","match":"..","edges":".."}
+// one result by line, in the order of the queries : {"id":..,"targets":[..]} or {"id":..,"error":".."}
+int32_t App::m_cmdBatch() const {
+    datas::SeedOptions seedOptions;
+    datas::TraversalOptions defaultTraversal;
+    if (!m_getQueryOptions(seedOptions, defaultTraversal)) {
+        return EXIT_FAILURE;
+    }
+    auto defaultTypes = m_getTypeMask();
+    if (defaultTypes == 0U) {
+        defaultTypes = datas::toMask(datas::TargetType::BINARY);
+    }
+
+    // one answer by query line, the ones already sent are answered together by the engine
+    struct Answer {
+        std::string id;
+        std::string error;
+        size_t queryIdx{};
+    };
+    constexpr size_t GROUP_MAX{1024U};
+    int32_t ret{EXIT_SUCCESS};
+    utils::LineReader reader(0);
+    std::string line;
+    utils::ndjson::Object query;
+    std::map<std::string, std::unique_ptr<utils::PathMatcher>> matchers;  // by match of the queries, compiled once
+    while (reader.readLine(line)) {
+        std::vector<Answer> answers;
+        std::vector<datas::PointedQuery> queries;
+        do {
+            if (line.find_first_not_of(" \t") == std::string::npos) {
+                continue;
+            }
+            Answer answer;
+            datas::PointedQuery pointed;
+            pointed.typeMask = defaultTypes;
+            pointed.traversalOptions = defaultTraversal;
+            pointed.pMatcher = mp_matcher.get();
+            std::vector<std::string> queryFiles;
+            std::string value;
+            if (!query.parse(line, answer.error)) {
+                answer.error = "bad query : " + answer.error;
+            } else if (query.has("files") && !query.getStringArray("files", queryFiles)) {
+                answer.error = "files must be an array of strings";
+            } else if (std::find(queryFiles.begin(), queryFiles.end(), "@-") != queryFiles.end()) {
+                answer.error = "@- is not allowed, stdin holds the queries";
+            } else if (!m_expandFileArgs(queryFiles, pointed.files, answer.error)) {
+                // error of the list file
+            } else if (query.getString("types", value) && !m_parseTypeLetters(value, pointed.typeMask)) {
+                answer.error = "unknown types " + value + ", expected letters of blsh";
+            } else if (query.getString("edges", value) && !m_parseEdgeKinds(value, pointed.traversalOptions.edgeKinds)) {
+                answer.error = "unknown edge kinds " + value;
+            } else if (query.getString("match", value) && !m_getMatcher(value, matchers, pointed.pMatcher, answer.error)) {
+                // error of the regex
+            } else {
+                answer.queryIdx = queries.size();
+                queries.push_back(std::move(pointed));
+            }
+            answer.id = query.getRaw("id");
+            answers.push_back(std::move(answer));
+        } while ((answers.size() < GROUP_MAX) && reader.hasLine() && reader.readLine(line));
+
+        const auto results = mp_loader->getPointedTargetsBatch(queries, seedOptions);
+        for (const auto& answer : answers) {
+            std::string result = "{\"id\":" + answer.id;
+            if (!answer.error.empty()) {
+                result += ",\"error\":" + utils::ndjson::quote(answer.error) + "}";
+                ret = EXIT_FAILURE;
+            } else {
+                result += ",\"targets\":[";
+                bool first{true};
+                for (const auto& target : m_mergeTargets(results[answer.queryIdx])) {
+                    result += (first ? "" : ",") + utils::ndjson::quote(target);
+                    first = false;
+                }
+                result += "]}";
+            }
+            std::cout << result << "\n";
+        }
+        std::cout << std::flush;  // streamed, the client can wait for the answers of its queries
+    }
+    return ret;
+}
+
+bool App::m_getQueryOptions(datas::SeedOptions& aoSeedOptions, datas::TraversalOptions& aoTraversalOptions) const {
+    aoSeedOptions.buildDir = fs::absolute(m_buildDir);
+    const auto sourceRoot = m_args.getValue<std::string>("source-root");
+    if (!sourceRoot.empty()) {
+        aoSeedOptions.match = datas::PathMatch::SUFFIX;
+        aoSeedOptions.sourceRoot = fs::absolute(sourceRoot);
+    } else if (m_args.isPresent("suffix")) {
+        aoSeedOptions.match = datas::PathMatch::SUFFIX;
+    }
+    const auto edges = m_args.getValue<std::string>("edges");
+    if (!edges.empty() && !m_parseEdgeKinds(edges, aoTraversalOptions.edgeKinds)) {
+        std::cerr << "Unknown edge kinds " << edges << ", expected explicit,implicit,order-only,deps,cmake or all" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool App::m_expandFileArgs(const std::vector<std::string>& aArgs, std::vector<std::string>& aoFiles, std::string& aoError) {
+    for (const auto& arg : aArgs) {
+        if (arg.size() > 1U && arg[0] == '@') {
+            if (!m_readFileList(arg.substr(1U), aoFiles, aoError)) {
+                return false;
+            }
+        } else {
+            aoFiles.push_back(arg);
+        }
+    }
+    return true;
+}
+
+bool App::m_readFileList(const std::string& aListFile, std::vector<std::string>& aoFiles, std::string& aoError) {
+    std::ifstream file;
+    if (aListFile != "-") {
+        file.open(aListFile);
+        if (!file.is_open()) {
+            aoError = "Cannot open list file " + aListFile;
+            return false;
+        }
+    }
+    std::istream& input = (aListFile == "-") ? std::cin : file;
+    std::string line;
+    while (std::getline(input, line)) {
+        const auto start = line.find_first_not_of(" \t");
+        if (start == std::string::npos) {
+            continue;
+        }
+        const auto end = line.find_last_not_of(" \t\r");
+        aoFiles.push_back(line.substr(start, end + 1U - start));
+    }
+    return true;
+}
+
+bool App::m_parseTypeLetters(const std::string& aLetters, datas::TargetTypeMask& aoMask) {
+    aoMask = 0U;
+    for (const char letter : aLetters) {
+        switch (letter) {
+            case 'b': aoMask |= datas::toMask(datas::TargetType::BINARY); break;
+            case 'l': aoMask |= datas::toMask(datas::TargetType::LIBRARY); break;
+            case 's': aoMask |= datas::toMask(datas::TargetType::SOURCE); break;
+            case 'h': aoMask |= datas::toMask(datas::TargetType::HEADER); break;
+            default: return false;
+        }
+    }
+    return aoMask != 0U;
+}
+
+bool App::m_parseEdgeKinds(const std::string& aKinds, datas::EdgeKindMask& aoMask) {
+    aoMask = 0U;
+    std::stringstream ss(aKinds);
+    std::string kind;
+    while (std::getline(ss, kind, ',')) {
+        if (kind == "all") {
+            aoMask |= datas::ALL_EDGE_KINDS;
+        } else if (kind == "explicit") {
+            aoMask |= datas::toMask(datas::EdgeKind::EXPLICIT);
+        } else if (kind == "implicit") {
+            aoMask |= datas::toMask(datas::EdgeKind::IMPLICIT);
+        } else if (kind == "order-only") {
+            aoMask |= datas::toMask(datas::EdgeKind::ORDER_ONLY);
+        } else if (kind == "deps") {
+            aoMask |= datas::toMask(datas::EdgeKind::DEPS_LOG);
+        } else if (kind == "cmake") {
+            aoMask |= datas::toMask(datas::EdgeKind::CMAKE);
+        } else {
+            return false;
+        }
+    }
+    return aoMask != 0U;
+}
+
+std::set<std::string> App::m_mergeTargets(const datas::TargetsByType& aTargetsByType) {
+    std::set<std::string> ret;
+    for (const auto& it : aTargetsByType) {
+        ret.insert(it.second.begin(), it.second.end());
+    }
+    return ret;
 }
 
 int32_t App::m_printTargets(const std::set<std::string>& aTargets) const {
     if (aTargets.empty()) {
         return EXIT_FAILURE;
     }
-    const auto pattern = ez::str::toLower(m_args.getValue<std::string>("match"));
     for (const auto& target : aTargets) {
-        if ((pattern.empty()) ||  //
-            (!ez::str::searchForPatternWithWildcards(ez::str::toLower(target), pattern).empty())) {
-            std::cout << target << "\n";
-        }
+        std::cout << target << "\n";
     }
     return EXIT_SUCCESS;
 }
 
+int32_t App::m_getNoTargetCode(const std::function<datas::TargetsByType()>& aGetUnmatched) const {
+    // the query without the matcher is only run in this rare case
+    if ((mp_matcher != nullptr) && !m_mergeTargets(aGetUnmatched()).empty()) {
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+bool App::m_getMatcher(
+    const std::string& aPatterns,
+    std::map<std::string, std::unique_ptr<utils::PathMatcher>>& arMatchers,
+    const utils::PathMatcher*& aoMatcher,
+    std::string& aoError) {
+    if (aPatterns.empty()) {
+        aoMatcher = nullptr;
+        return true;
+    }
+    auto it = arMatchers.find(aPatterns);
+    if (it == arMatchers.end()) {
+        auto matcher = utils::PathMatcher::create(aPatterns);
+        if (matcher.first == nullptr) {
+            aoError = matcher.second;
+            return false;
+        }
+        it = arMatchers.emplace(aPatterns, std::move(matcher.first)).first;
+    }
+    aoMatcher = it->second.get();
+    return true;
+}
+
 }  // namespace kunai
@@ -3,8 +3,15 @@
 #include <ezlibs/ezArgs.hpp>
 
 #include <app/loader/loader.h>
+#include <app/utils/local_socket.h>
+#include <app/utils/path_matcher.h>
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 #include <cstdint>
+#include <functional>
 #include <filesystem>
 
 namespace kunai {
@@ -13,8 +20,13 @@ class Loader;
 class App {
 private:
     ez::Args m_args;
+    std::vector<std::string> m_rawArgs;
     std::filesystem::path m_buildDir;
-    std::unique_ptr<Loader> mp_loader;
+    datas::Backend m_backend{datas::Backend::SQLITE};
+    datas::HashAlgo m_hashAlgo{datas::HashAlgo::FAST128};
+    uint32_t m_lockTimeoutMs{600000U};  // --lock-timeout
+    std::shared_ptr<Loader> mp_loader;  // shared with the requests of the serve daemon
+    std::unique_ptr<utils::PathMatcher> mp_matcher;  // compiled --match, nullptr if none
 
 public:
     bool init(int32_t argc, char** argv);
@@ -22,10 +34,44 @@ public:
     int32_t run();
 
 private:
+    bool m_parseArgs(int32_t argc, char** argv);
+    int32_t m_runCommand() const;
+    // false if no daemon serves the build dir, or if the command must run locally
+    bool m_runOnDaemon(uint32_t aLockTimeoutMs, int32_t& aoRet) const;
+    int32_t m_cmdServe(uint32_t aLockTimeoutMs);
+    void m_serveClient(utils::LocalSocket& arClient) const;
+    int32_t m_cmdWatch();
     int32_t m_cmdStats() const;
+    int32_t m_cmdHotspots() const;
     int32_t m_cmdAllTargetsByType() const;
     int32_t m_cmdPointedTargetsByType() const;
+    int32_t m_cmdBatch() const;
+    int32_t m_cmdRebuildSet() const;
+    int32_t m_cmdFingerprint() const;
+    // single quoted if needed, for a posix shell
+    static std::string m_quoteShellArg(const std::string& aArg);
+    // seed options and edge kinds of the command line, shared by pointed and batch
+    bool m_getQueryOptions(datas::SeedOptions& aoSeedOptions, datas::TraversalOptions& aoTraversalOptions) const;
+    // "@list-file" args are replaced by the files of the list
+    static bool m_expandFileArgs(const std::vector<std::string>& aArgs, std::vector<std::string>& aoFiles, std::string& aoError);
+    // one file by line, "-" for stdin
+    static bool m_readFileList(const std::string& aListFile, std::vector<std::string>& aoFiles, std::string& aoError);
     int32_t m_printTargets(const std::set<std::string>& aTargets) const;
+    // exit code of a query without targets. a success if --match filtered out the targets aGetUnmatched() finds,
+    // like when --match was applied on the printed targets
+    int32_t m_getNoTargetCode(const std::function<datas::TargetsByType()>& aGetUnmatched) const;
+    // compiled once by patterns in arMatchers, nullptr for empty patterns
+    static bool m_getMatcher(
+        const std::string& aPatterns,
+        std::map<std::string, std::unique_ptr<utils::PathMatcher>>& arMatchers,
+        const utils::PathMatcher*& aoMatcher,
+        std::string& aoError);
+    datas::TargetTypeMask m_getTypeMask() const;
+    static std::set<std::string> m_mergeTargets(const datas::TargetsByType& aTargetsByType);
+    // ex : "bl" for binaries and libraries
+    static bool m_parseTypeLetters(const std::string& aLetters, datas::TargetTypeMask& aoMask);
+    // ex : "explicit,deps" or "all"
+    static bool m_parseEdgeKinds(const std::string& aKinds, datas::EdgeKindMask& aoMask);
 };
 
 }  // namespace kunai
@@ -0,0 +1,161 @@
+#include "bitmap.h"
+
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+
+namespace kunai {
+namespace graph {
+
+template <typename T>
+static void appendPod(std::string& arBuffer, const T& aValue) {
+    arBuffer.append(reinterpret_cast<const char*>(&aValue), sizeof(T));
+}
+
+template <typename T>
+static T readPod(const uint8_t* apDatas) {
+    T ret;
+    std::memcpy(&ret, apDatas, sizeof(T));
+    return ret;
+}
+
+size_t Bitmap::Chunk::count() const {
+    if (bits.empty()) {
+        return array.size();
+    }
+    size_t ret = 0U;
+    for (const auto word : bits) {
+        uint64_t w = word;
+        while (w != 0U) {
+            w &= w - 1U;
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+void Bitmap::Chunk::toBitset() {
+    bits.assign(BITSET_WORDS, 0U);
+    for (const auto v : array) {
+        bits[v >> 6U] |= (1ULL << (v & 63U));
+    }
+    array.clear();
+    array.shrink_to_fit();
+}
+
+Bitmap::Chunk& Bitmap::m_getChunk(uint16_t aKey) {
+    auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), aKey, [](const Chunk& c, uint16_t k) { return c.key < k; });
+    if (it == m_chunks.end() || it->key != aKey) {
+        Chunk chunk;
+        chunk.key = aKey;
+        it = m_chunks.insert(it, chunk);
+    }
+    return *it;
+}
+
+void Bitmap::add(uint32_t aValue) {
+    auto& chunk = m_getChunk(static_cast<uint16_t>(aValue >> 16U));
+    const auto low = static_cast<uint16_t>(aValue & 0xFFFFU);
+    if (!chunk.bits.empty()) {
+        chunk.bits[low >> 6U] |= (1ULL << (low & 63U));
+        return;
+    }
+    auto it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+    if (it == chunk.array.end() || *it != low) {
+        chunk.array.insert(it, low);
+        if (chunk.array.size() > ARRAY_MAX_COUNT) {
+            chunk.toBitset();
+        }
+    }
+}
+
+void Bitmap::orWith(const Bitmap& aOther) {
+    for (const auto& other : aOther.m_chunks) {
+        auto& chunk = m_getChunk(other.key);
+        if (!chunk.bits.empty()) {
+            if (!other.bits.empty()) {
+                for (size_t i = 0U; i < BITSET_WORDS; ++i) {
+                    chunk.bits[i] |= other.bits[i];
+                }
+            } else {
+                for (const auto v : other.array) {
+                    chunk.bits[v >> 6U] |= (1ULL << (v & 63U));
+                }
+            }
+        } else if (!other.bits.empty()) {
+            const auto array = std::move(chunk.array);
+            chunk.array.clear();
+            chunk.bits = other.bits;
+            for (const auto v : array) {
+                chunk.bits[v >> 6U] |= (1ULL << (v & 63U));
+            }
+        } else {
+            std::vector<uint16_t> merged;
+            merged.reserve(chunk.array.size() + other.array.size());
+            std::set_union(chunk.array.begin(), chunk.array.end(), other.array.begin(), other.array.end(), std::back_inserter(merged));
+            chunk.array = std::move(merged);
+            if (chunk.array.size() > ARRAY_MAX_COUNT) {
+                chunk.toBitset();
+            }
+        }
+    }
+}
+
+void Bitmap::serialize(std::string& arBuffer) const {
+    appendPod(arBuffer, static_cast<uint32_t>(m_chunks.size()));
+    for (const auto& chunk : m_chunks) {
+        appendPod(arBuffer, chunk.key);
+        if (chunk.bits.empty()) {
+            appendPod(arBuffer, static_cast<uint16_t>(0U));
+            appendPod(arBuffer, static_cast<uint32_t>(chunk.array.size()));
+            arBuffer.append(reinterpret_cast<const char*>(chunk.array.data()), chunk.array.size() * sizeof(uint16_t));
+        } else {
+            appendPod(arBuffer, static_cast<uint16_t>(1U));
+            appendPod(arBuffer, static_cast<uint32_t>(chunk.count()));
+            arBuffer.append(reinterpret_cast<const char*>(chunk.bits.data()), BITSET_WORDS * sizeof(uint64_t));
+        }
+    }
+}
+
+void Bitmap::orSerializedInto(const uint8_t* apDatas, size_t aSize, std::vector<uint64_t>& arDense) {
+    if (aSize < sizeof(uint32_t)) {
+        return;
+    }
+    const uint8_t* ptr = apDatas;
+    const uint8_t* end = apDatas + aSize;
+    const auto chunksCount = readPod<uint32_t>(ptr);
+    ptr += sizeof(uint32_t);
+    for (uint32_t c = 0U; c < chunksCount; ++c) {
+        if (ptr + 8U > end) {
+            return;
+        }
+        const size_t base = static_cast<size_t>(readPod<uint16_t>(ptr)) << 16U;
+        const auto kind = readPod<uint16_t>(ptr + 2U);
+        const auto count = readPod<uint32_t>(ptr + 4U);
+        ptr += 8U;
+        if (kind == 0U) {
+            if (ptr + count * sizeof(uint16_t) > end) {
+                return;
+            }
+            for (uint32_t i = 0U; i < count; ++i) {
+                const size_t v = base | readPod<uint16_t>(ptr + i * sizeof(uint16_t));
+                if ((v >> 6U) < arDense.size()) {
+                    arDense[v >> 6U] |= (1ULL << (v & 63U));
+                }
+            }
+            ptr += count * sizeof(uint16_t);
+        } else {
+            if (ptr + BITSET_WORDS * sizeof(uint64_t) > end) {
+                return;
+            }
+            const size_t firstWord = base >> 6U;
+            for (size_t i = 0U; i < BITSET_WORDS && (firstWord + i) < arDense.size(); ++i) {
+                arDense[firstWord + i] |= readPod<uint64_t>(ptr + i * sizeof(uint64_t));
+            }
+            ptr += BITSET_WORDS * sizeof(uint64_t);
+        }
+    }
+}
+
+}  // namespace graph
+}  // namespace kunai
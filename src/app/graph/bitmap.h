@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * Bitmap - compressed bitmap of 32 bits values (roaring style)
+ *
+ * Values are split in 64k chunks keyed by their 16 high bits.
+ * A chunk is a sorted array of the 16 low bits while it holds at most 4096 values,
+ * and a 65536 bits bitset beyond.
+ *
+ * Serialized form (read back without alignment constraints) :
+ *   u32 chunks count
+ *   per chunk : u16 key | u16 kind (0 array, 1 bitset) | u32 count | payload
+ *   payload   : u16[count] for an array, u64[1024] for a bitset
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace kunai {
+namespace graph {
+
+class Bitmap {
+public:
+    static constexpr size_t ARRAY_MAX_COUNT = 4096U;
+    static constexpr size_t BITSET_WORDS = 1024U;
+
+private:
+    struct Chunk {
+        uint16_t key{};
+        std::vector<uint16_t> array;  // used while bits is empty
+        std::vector<uint64_t> bits;   // BITSET_WORDS words when the chunk is dense
+        size_t count() const;
+        void toBitset();
+    };
+    std::vector<Chunk> m_chunks;  // sorted by key
+
+public:
+    void add(uint32_t aValue);
+    void orWith(const Bitmap& aOther);
+
+    // append the serialized bitmap to arBuffer
+    void serialize(std::string& arBuffer) const;
+
+    // Or a serialized bitmap into a dense bitset (one bit per value, in 64 bits words)
+    static void orSerializedInto(const uint8_t* apDatas, size_t aSize, std::vector<uint64_t>& arDense);
+
+private:
+    Chunk& m_getChunk(uint16_t aKey);
+};
+
+}  // namespace graph
+}  // namespace kunai
@@ -0,0 +1,269 @@
+#include "closure.h"
+
+#include <app/graph/bitmap.h>
+#include <app/utils/paths.h>
+
+#include <limits>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace graph {
+
+constexpr char Closure::MAGIC[8];
+
+static constexpr uint32_t UNVISITED = std::numeric_limits<uint32_t>::max();
+
+static uint64_t alignOn8(uint64_t aOffset) {
+    return (aOffset + 7U) & ~static_cast<uint64_t>(7U);
+}
+
+bool Closure::isTargetType(datas::TargetType aType) {
+    return (aType == datas::TargetType::LIBRARY) || (aType == datas::TargetType::BINARY);
+}
+
+bool Closure::write(const Snapshot& aSnapshot, const fs::path& aFilePath, std::string& aoError, datas::EdgeKindMask aEdgeKinds) {
+    const uint32_t nodesCount = aSnapshot.getNodesCount();
+
+    // Dense target indexes
+    std::vector<uint32_t> targets;
+    std::vector<uint32_t> targetIndexes(nodesCount, UNVISITED);
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        if (isTargetType(aSnapshot.getType(id))) {
+            targetIndexes[id] = static_cast<uint32_t>(targets.size());
+            targets.push_back(id);
+        }
+    }
+
+    // Iterative Tarjan over the reverse edges. a component is completed only after
+    // every component it reaches, so its bitmap can be merged from theirs at once
+    std::vector<uint32_t> indexes(nodesCount, UNVISITED);
+    std::vector<uint32_t> lows(nodesCount, 0U);
+    std::vector<uint32_t> components(nodesCount, UNVISITED);
+    std::vector<uint8_t> onStack(nodesCount, 0U);
+    std::vector<uint32_t> stack;
+    std::vector<std::pair<uint32_t, const uint32_t*>> frames;  // node, next dependent to visit
+    std::vector<Bitmap> bitmaps;                                // per component
+    std::vector<uint32_t> lastMerged;                           // per component, last component merged into
+    uint32_t nextIndex = 0U;
+
+    for (uint32_t root = 0U; root < nodesCount; ++root) {
+        if (indexes[root] != UNVISITED) {
+            continue;
+        }
+        indexes[root] = lows[root] = nextIndex++;
+        stack.push_back(root);
+        onStack[root] = 1U;
+        frames.emplace_back(root, aSnapshot.getDependents(root).begin());
+        while (!frames.empty()) {
+            auto& frame = frames.back();
+            const auto v = frame.first;
+            const auto range = aSnapshot.getDependents(v);
+            if (frame.second != range.end()) {
+                const auto* edge = frame.second++;
+                if (!range.isFollowed(edge, aEdgeKinds)) {
+                    continue;
+                }
+                const auto w = *edge;
+                if (indexes[w] == UNVISITED) {
+                    indexes[w] = lows[w] = nextIndex++;
+                    stack.push_back(w);
+                    onStack[w] = 1U;
+                    frames.emplace_back(w, aSnapshot.getDependents(w).begin());
+                } else if (onStack[w] != 0U) {
+                    lows[v] = std::min(lows[v], indexes[w]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (!frames.empty()) {
+                const auto parent = frames.back().first;
+                lows[parent] = std::min(lows[parent], lows[v]);
+            }
+            if (lows[v] != indexes[v]) {
+                continue;
+            }
+            // v is the root of a component
+            const auto component = static_cast<uint32_t>(bitmaps.size());
+            bitmaps.emplace_back();
+            lastMerged.push_back(UNVISITED);
+            const auto firstMember = std::find(stack.rbegin(), stack.rend(), v).base() - 1;
+            for (auto it = firstMember; it != stack.end(); ++it) {
+                onStack[*it] = 0U;
+                components[*it] = component;
+            }
+            auto& bitmap = bitmaps.back();
+            for (auto it = firstMember; it != stack.end(); ++it) {
+                if (targetIndexes[*it] != UNVISITED) {
+                    bitmap.add(targetIndexes[*it]);
+                }
+                const auto dependents = aSnapshot.getDependents(*it);
+                for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+                    if (!dependents.isFollowed(edge, aEdgeKinds)) {
+                        continue;
+                    }
+                    const auto other = components[*edge];
+                    if (other != component && lastMerged[other] != component) {
+                        lastMerged[other] = component;
+                        bitmap.orWith(bitmaps[other]);
+                    }
+                }
+            }
+            stack.erase(firstMember, stack.end());
+        }
+    }
+
+    // Only sources and headers are stored
+    std::vector<uint64_t> bitmapOffsets{0U};
+    bitmapOffsets.reserve(nodesCount + 1U);
+    std::string blob;
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        const auto type = aSnapshot.getType(id);
+        if ((type == datas::TargetType::SOURCE) || (type == datas::TargetType::HEADER)) {
+            bitmaps[components[id]].serialize(blob);
+        }
+        bitmapOffsets.push_back(blob.size());
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.nodesCount = nodesCount;
+    header.targetsCount = static_cast<uint32_t>(targets.size());
+    header.edgeKinds = aEdgeKinds;
+    std::strncpy(header.stamp, aSnapshot.getStamp().c_str(), sizeof(header.stamp) - 1U);
+    header.targetsOffset = alignOn8(sizeof(Header));
+    header.bitmapOffsetsOffset = alignOn8(header.targetsOffset + targets.size() * sizeof(uint32_t));
+    header.bitmapsOffset = alignOn8(header.bitmapOffsetsOffset + bitmapOffsets.size() * sizeof(uint64_t));
+
+    // Written aside then renamed, so a reader never maps a partial file.
+    // the temporary file is our own : another writer can't truncate it once renamed and mapped
+    const auto tmpFilePath = utils::paths::getTmpPath(aFilePath);
+    {
+        std::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            aoError = "Cannot open file: " + tmpFilePath.string();
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.seekp(static_cast<std::streamoff>(header.targetsOffset));
+        file.write(reinterpret_cast<const char*>(targets.data()), static_cast<std::streamsize>(targets.size() * sizeof(uint32_t)));
+        file.seekp(static_cast<std::streamoff>(header.bitmapOffsetsOffset));
+        file.write(reinterpret_cast<const char*>(bitmapOffsets.data()), static_cast<std::streamsize>(bitmapOffsets.size() * sizeof(uint64_t)));
+        file.seekp(static_cast<std::streamoff>(header.bitmapsOffset));
+        file.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+        if (!file.good()) {
+            aoError = "Cannot write file: " + tmpFilePath.string();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmpFilePath, aFilePath, ec);
+    if (ec) {
+        aoError = "Cannot replace " + aFilePath.string() + " : " + ec.message();
+        fs::remove(tmpFilePath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::pair<std::unique_ptr<Closure>, std::string> Closure::create(const fs::path& aFilePath) {
+    auto pRet = std::make_unique<Closure>();
+    std::string error;
+    if (!pRet->m_open(aFilePath)) {
+        error = pRet->getError();
+        pRet.reset();
+    }
+    return std::make_pair(std::move(pRet), error);
+}
+
+std::string Closure::getError() const {
+    return m_error.str();
+}
+
+std::string Closure::getStamp() const {
+    return std::string(mp_header->stamp, strnlen(mp_header->stamp, sizeof(mp_header->stamp)));
+}
+
+uint32_t Closure::getNodesCount() const {
+    return mp_header->nodesCount;
+}
+
+datas::EdgeKindMask Closure::getEdgeKinds() const {
+    return mp_header->edgeKinds;
+}
+
+uint32_t Closure::getTargetsCount() const {
+    return mp_header->targetsCount;
+}
+
+uint32_t Closure::getTargetNodeId(uint32_t aTargetIdx) const {
+    return mp_targets[aTargetIdx];
+}
+
+bool Closure::getTargetIndex(uint32_t aNodeId, uint32_t& aoTargetIdx) const {
+    const auto* end = mp_targets + mp_header->targetsCount;
+    const auto* it = std::lower_bound(mp_targets, end, aNodeId);
+    if (it == end || *it != aNodeId) {
+        return false;
+    }
+    aoTargetIdx = static_cast<uint32_t>(it - mp_targets);
+    return true;
+}
+
+bool Closure::isIndexed(uint32_t aNodeId) const {
+    return mp_bitmapOffsets[aNodeId + 1U] != mp_bitmapOffsets[aNodeId];
+}
+
+void Closure::orReachInto(uint32_t aNodeId, std::vector<uint64_t>& arDense) const {
+    const auto start = mp_bitmapOffsets[aNodeId];
+    Bitmap::orSerializedInto(mp_bitmaps + start, static_cast<size_t>(mp_bitmapOffsets[aNodeId + 1U] - start), arDense);
+}
+
+bool Closure::m_open(const fs::path& aFilePath) {
+    auto tmp_pFile = utils::MappedFile::create(aFilePath);
+    if (tmp_pFile.first == nullptr) {
+        m_error << tmp_pFile.second;
+        return false;
+    }
+    mp_file = std::move(tmp_pFile.first);
+
+    const auto* datas = mp_file->getDatas();
+    const auto size = static_cast<uint64_t>(mp_file->size());
+    if (size < sizeof(Header)) {
+        m_error << "Truncated closure index: " << aFilePath.string();
+        return false;
+    }
+    mp_header = reinterpret_cast<const Header*>(datas);
+    if (std::memcmp(mp_header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        m_error << "Invalid closure index signature: " << aFilePath.string();
+        return false;
+    }
+    if (mp_header->version != VERSION) {
+        m_error << "Unsupported closure index version: " << std::to_string(mp_header->version);
+        return false;
+    }
+    const uint64_t nodes = mp_header->nodesCount;
+    const uint64_t targets = mp_header->targetsCount;
+    const bool sectionsOk = (mp_header->targetsOffset + targets * sizeof(uint32_t) <= size)  //
+        && (mp_header->bitmapOffsetsOffset + (nodes + 1U) * sizeof(uint64_t) <= size);
+    if (!sectionsOk) {
+        m_error << "Truncated closure index: " << aFilePath.string();
+        return false;
+    }
+    mp_targets = reinterpret_cast<const uint32_t*>(datas + mp_header->targetsOffset);
+    mp_bitmapOffsets = reinterpret_cast<const uint64_t*>(datas + mp_header->bitmapOffsetsOffset);
+    mp_bitmaps = datas + mp_header->bitmapsOffset;
+    if (mp_header->bitmapsOffset + mp_bitmapOffsets[nodes] > size) {
+        m_error << "Truncated closure index: " << aFilePath.string();
+        return false;
+    }
+    return true;
+}
+
+}  // namespace graph
+}  // namespace kunai
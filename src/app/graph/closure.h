@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+ * Closure - precomputed transitive closure index of a graph Snapshot
+ *
+ * For each source and header node, stores the compressed Bitmap of the
+ * libraries and binaries it reaches through the reverse edges of the given kinds.
+ * The bitmaps are computed bottom-up over the strongly connected components,
+ * in topological order, so each edge is merged only once.
+ *
+ * Libraries and binaries are numbered by a dense target index (ascending node id).
+ *
+ * Layout (little endian, sections aligned on 8 bytes) :
+ *   Header | targets u32[T] (node id of each target index) |
+ *   bitmap offsets u64[N+1] | serialized bitmaps
+ * A node without bitmap (not a source nor a header) has an empty byte range.
+ */
+
+#include <app/graph/snapshot.h>
+#include <app/utils/mapped_file.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <cstdint>
+#include <filesystem>
+
+namespace kunai {
+namespace graph {
+
+class Closure {
+public:
+    static constexpr char MAGIC[8] = {'K', 'U', 'N', 'A', 'I', 'C', 'L', 'O'};
+    static constexpr uint32_t VERSION = 2U;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t nodesCount;
+        uint32_t targetsCount;
+        uint32_t edgeKinds;  // kinds of the edges followed
+        uint64_t targetsOffset;
+        uint64_t bitmapOffsetsOffset;
+        uint64_t bitmapsOffset;
+        char stamp[128];  // stamp of the snapshot the index was computed from
+    };
+
+    // Compute and write the index of aSnapshot. the file is replaced atomically
+    static bool write(
+        const Snapshot& aSnapshot,
+        const std::filesystem::path& aFilePath,
+        std::string& aoError,
+        datas::EdgeKindMask aEdgeKinds = datas::DEFAULT_EDGE_KINDS);
+
+    // Map an index file
+    static std::pair<std::unique_ptr<Closure>, std::string> create(const std::filesystem::path& aFilePath);
+
+    // true for the types reached by the index
+    static bool isTargetType(datas::TargetType aType);
+
+private:
+    std::stringstream m_error;
+    std::unique_ptr<utils::MappedFile> mp_file;
+    const Header* mp_header{nullptr};
+    const uint32_t* mp_targets{nullptr};
+    const uint64_t* mp_bitmapOffsets{nullptr};
+    const uint8_t* mp_bitmaps{nullptr};
+
+public:
+    Closure() = default;
+    Closure(const Closure&) = delete;
+    Closure& operator=(const Closure&) = delete;
+
+    std::string getError() const;
+    std::string getStamp() const;
+
+    uint32_t getNodesCount() const;
+    datas::EdgeKindMask getEdgeKinds() const;
+    uint32_t getTargetsCount() const;
+    uint32_t getTargetNodeId(uint32_t aTargetIdx) const;
+    // return false if aNodeId is not a library nor a binary
+    bool getTargetIndex(uint32_t aNodeId, uint32_t& aoTargetIdx) const;
+
+    // true if the reach of aNodeId is stored
+    bool isIndexed(uint32_t aNodeId) const;
+    // Or the targets reached by aNodeId into a dense bitset of getTargetsCount() bits
+    void orReachInto(uint32_t aNodeId, std::vector<uint64_t>& arDense) const;
+
+private:
+    bool m_open(const std::filesystem::path& aFilePath);
+};
+
+}  // namespace graph
+}  // namespace kunai
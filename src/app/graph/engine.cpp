@@ -0,0 +1,374 @@
+#include "engine.h"
+
+#include <app/utils/paths.h>
+#include <app/utils/substring_matcher.h>
+#include <app/utils/path_matcher.h>
+
+#include <map>
+#include <algorithm>
+
+namespace kunai {
+namespace graph {
+
+// the matcher is given the path in the snapshot, before any string is built
+static bool isAccepted(const utils::PathMatcher* apMatcher, std::string_view aPath) {
+    return (apMatcher == nullptr) || apMatcher->isMatching(aPath);
+}
+
+Engine::Engine(const Snapshot& arSnapshot, const Closure* apClosure) : mr_snapshot(arSnapshot), mp_closure(apClosure) {
+}
+
+datas::TargetsByType Engine::getAllTargets(datas::TargetTypeMask aTypeMask, const utils::PathMatcher* apMatcher) const {
+    datas::TargetsByType ret;
+    const auto nodesCount = mr_snapshot.getNodesCount();
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        const auto type = mr_snapshot.getType(id);
+        if (datas::hasType(aTypeMask, type)) {
+            const auto path = mr_snapshot.getPath(id);
+            if (isAccepted(apMatcher, path)) {
+                ret[type].emplace_back(path);
+            }
+        }
+    }
+    return ret;
+}
+
+datas::TargetsByType Engine::getPointedTargets(
+    const std::vector<std::string>& sourcePaths,
+    datas::TargetTypeMask aTypeMask,
+    const datas::SeedOptions& aSeedOptions,
+    const datas::TraversalOptions& aTraversalOptions,
+    const utils::PathMatcher* apMatcher) const {
+    datas::TargetsByType ret;
+    if (sourcePaths.empty()) {
+        return ret;
+    }
+
+    // the closure index only knows libraries and binaries, reached by its own edge kinds
+    const auto closureMask = datas::toMask(datas::TargetType::LIBRARY) | datas::toMask(datas::TargetType::BINARY);
+    if ((mp_closure != nullptr) && ((aTypeMask & ~closureMask) == 0U) && (mp_closure->getEdgeKinds() == aTraversalOptions.edgeKinds)) {
+        return m_getPointedTargetsFromClosure(m_getSeeds(sourcePaths, aSeedOptions), aTypeMask, apMatcher);
+    }
+
+    // BFS on the reverse edges from the seeds
+    std::vector<uint8_t> visited(mr_snapshot.getNodesCount(), 0U);
+    std::vector<uint32_t> queue = m_getSeeds(sourcePaths, aSeedOptions);
+    for (const auto id : queue) {
+        visited[id] = 1U;
+    }
+
+    // objects are not asked, the BFS runs on the contracted graph
+    if (!datas::hasType(aTypeMask, datas::TargetType::OBJECT) && (mr_snapshot.getContractedKinds() == aTraversalOptions.edgeKinds)) {
+        m_walkContracted(queue, visited);
+        for (const auto id : queue) {
+            const auto type = mr_snapshot.getType(id);
+            if (datas::hasType(aTypeMask, type) && isAccepted(apMatcher, mr_snapshot.getPath(id))) {
+                ret[type].emplace_back(mr_snapshot.getPath(id));
+            }
+        }
+        return ret;
+    }
+
+    for (size_t idx = 0U; idx < queue.size(); ++idx) {
+        const auto id = queue[idx];
+        const auto type = mr_snapshot.getType(id);
+        if (datas::hasType(aTypeMask, type) && isAccepted(apMatcher, mr_snapshot.getPath(id))) {
+            ret[type].emplace_back(mr_snapshot.getPath(id));
+        }
+        const auto dependents = mr_snapshot.getDependents(id);
+        for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+            const auto dependent = *edge;
+            if ((visited[dependent] == 0U) && dependents.isFollowed(edge, aTraversalOptions.edgeKinds)) {
+                visited[dependent] = 1U;
+                queue.push_back(dependent);
+            }
+        }
+    }
+    return ret;
+}
+
+void Engine::forEachPointedLevel(
+    const std::vector<std::string>& sourcePaths,
+    datas::TargetTypeMask aTypeMask,
+    const datas::SeedOptions& aSeedOptions,
+    const datas::TraversalOptions& aTraversalOptions,
+    const utils::PathMatcher* apMatcher,
+    const std::function<void(uint32_t aDepth, const std::vector<uint32_t>& aNodeIds)>& aOnLevel) const {
+    if (sourcePaths.empty()) {
+        return;
+    }
+    // the contracted graph and the closure index would skip the object hops, the depth is counted on the full graph
+    std::vector<uint8_t> visited(mr_snapshot.getNodesCount(), 0U);
+    std::vector<uint32_t> level = m_getSeeds(sourcePaths, aSeedOptions);
+    for (const auto id : level) {
+        visited[id] = 1U;
+    }
+    std::vector<uint32_t> nextLevel;
+    std::vector<uint32_t> targets;
+    for (uint32_t depth = 0U; !level.empty(); ++depth) {
+        targets.clear();
+        for (const auto id : level) {
+            if (datas::hasType(aTypeMask, mr_snapshot.getType(id)) && isAccepted(apMatcher, mr_snapshot.getPath(id))) {
+                targets.push_back(id);
+            }
+        }
+        if (!targets.empty()) {
+            aOnLevel(depth, targets);
+        }
+        nextLevel.clear();
+        for (const auto id : level) {
+            const auto dependents = mr_snapshot.getDependents(id);
+            for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+                const auto dependent = *edge;
+                if ((visited[dependent] == 0U) && dependents.isFollowed(edge, aTraversalOptions.edgeKinds)) {
+                    visited[dependent] = 1U;
+                    nextLevel.push_back(dependent);
+                }
+            }
+        }
+        level.swap(nextLevel);
+    }
+}
+
+datas::TargetsByType Engine::m_getPointedTargetsFromClosure(
+    const std::vector<uint32_t>& aSeeds,
+    datas::TargetTypeMask aTypeMask,
+    const utils::PathMatcher* apMatcher) const {
+    std::vector<uint64_t> reached((mp_closure->getTargetsCount() + 63U) / 64U, 0U);
+
+    // indexed seeds are merged at once, the others (objects, libraries..)
+    // are walked until an indexed node or a target is found
+    std::vector<uint8_t> visited;
+    std::vector<uint32_t> queue;
+    for (const auto seed : aSeeds) {
+        if (mp_closure->isIndexed(seed)) {
+            mp_closure->orReachInto(seed, reached);
+        } else {
+            queue.push_back(seed);
+        }
+    }
+    if (!queue.empty()) {
+        visited.assign(mr_snapshot.getNodesCount(), 0U);
+        for (const auto id : queue) {
+            visited[id] = 1U;
+        }
+    }
+    for (size_t idx = 0U; idx < queue.size(); ++idx) {
+        const auto id = queue[idx];
+        if (mp_closure->isIndexed(id)) {
+            mp_closure->orReachInto(id, reached);
+            continue;
+        }
+        uint32_t targetIdx{};
+        if (mp_closure->getTargetIndex(id, targetIdx)) {
+            reached[targetIdx >> 6U] |= (1ULL << (targetIdx & 63U));
+        }
+        const auto dependents = mr_snapshot.getDependents(id);
+        for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+            const auto dependent = *edge;
+            if ((visited[dependent] == 0U) && dependents.isFollowed(edge, mp_closure->getEdgeKinds())) {
+                visited[dependent] = 1U;
+                queue.push_back(dependent);
+            }
+        }
+    }
+
+    datas::TargetsByType ret;
+    for (size_t w = 0U; w < reached.size(); ++w) {
+        for (uint64_t word = reached[w]; word != 0U; word &= word - 1U) {
+            uint32_t bit = 0U;
+            while (((word >> bit) & 1U) == 0U) {
+                ++bit;
+            }
+            const auto nodeId = mp_closure->getTargetNodeId(static_cast<uint32_t>(w * 64U + bit));
+            const auto type = mr_snapshot.getType(nodeId);
+            if (datas::hasType(aTypeMask, type) && isAccepted(apMatcher, mr_snapshot.getPath(nodeId))) {
+                ret[type].emplace_back(mr_snapshot.getPath(nodeId));
+            }
+        }
+    }
+    return ret;
+}
+
+std::vector<datas::TargetsByType> Engine::getPointedTargetsBatch(const std::vector<datas::PointedQuery>& aQueries, const datas::SeedOptions& aSeedOptions) const {
+    constexpr size_t LANES{64U};
+    std::vector<datas::TargetsByType> ret(aQueries.size());
+    std::map<datas::EdgeKindMask, std::vector<size_t>> queriesByKinds;
+    for (size_t idx = 0U; idx < aQueries.size(); ++idx) {
+        if (!aQueries[idx].files.empty() && (aQueries[idx].typeMask != 0U)) {
+            queriesByKinds[aQueries[idx].traversalOptions.edgeKinds].push_back(idx);
+        }
+    }
+    const auto nodesCount = mr_snapshot.getNodesCount();
+    std::vector<uint64_t> reached(nodesCount);
+    for (const auto& group : queriesByKinds) {
+        const auto kinds = group.first;
+        bool cyclic{false};
+        const auto order = m_getSweepOrder(kinds, cyclic);
+        for (size_t first = 0U; first < group.second.size(); first += LANES) {
+            const auto lanesCount = std::min(LANES, group.second.size() - first);
+            std::fill(reached.begin(), reached.end(), 0U);
+            std::vector<const std::vector<std::string>*> laneFiles;
+            for (size_t lane = 0U; lane < lanesCount; ++lane) {
+                laneFiles.push_back(&aQueries[group.second[first + lane]].files);
+            }
+            m_seedLanes(laneFiles, aSeedOptions, reached);
+            // a cycle may need more sweeps, a dag gets all its reaches in one
+            bool changed{true};
+            while (changed) {
+                changed = false;
+                for (const auto id : order) {
+                    const auto bits = reached[id];
+                    if (bits == 0U) {
+                        continue;
+                    }
+                    const auto dependents = mr_snapshot.getDependents(id);
+                    for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+                        auto& dependentBits = reached[*edge];
+                        if (((dependentBits | bits) != dependentBits) && dependents.isFollowed(edge, kinds)) {
+                            dependentBits |= bits;
+                            changed = true;
+                        }
+                    }
+                }
+                changed = changed && cyclic;
+            }
+            for (uint32_t id = 0U; id < nodesCount; ++id) {
+                const auto type = mr_snapshot.getType(id);
+                for (uint64_t bits = reached[id]; bits != 0U; bits &= bits - 1U) {
+                    size_t lane = 0U;
+                    while (((bits >> lane) & 1U) == 0U) {
+                        ++lane;
+                    }
+                    const auto queryIdx = group.second[first + lane];
+                    if (datas::hasType(aQueries[queryIdx].typeMask, type) && isAccepted(aQueries[queryIdx].pMatcher, mr_snapshot.getPath(id))) {
+                        ret[queryIdx][type].emplace_back(mr_snapshot.getPath(id));
+                    }
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+void Engine::m_seedLanes(const std::vector<const std::vector<std::string>*>& aLaneFiles, const datas::SeedOptions& aSeedOptions, std::vector<uint64_t>& arReached) const {
+    if (aSeedOptions.match == datas::PathMatch::SUFFIX) {
+        for (size_t lane = 0U; lane < aLaneFiles.size(); ++lane) {
+            for (const auto id : m_getSeeds(*aLaneFiles[lane], aSeedOptions)) {
+                arReached[id] |= (1ULL << lane);
+            }
+        }
+        return;
+    }
+    // the files of all the lanes in one automaton, the paths are read once
+    std::vector<std::string> needles;
+    std::vector<uint64_t> needleBits;
+    for (size_t lane = 0U; lane < aLaneFiles.size(); ++lane) {
+        for (const auto& file : *aLaneFiles[lane]) {
+            needles.push_back(file);
+            needleBits.push_back(1ULL << lane);
+        }
+    }
+    const utils::SubStringMatcher matcher(needles);
+    const auto nodesCount = mr_snapshot.getNodesCount();
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        uint64_t bits{};
+        matcher.forEachMatch(mr_snapshot.getPath(id), [&bits, &needleBits](uint32_t aNeedleIdx) { bits |= needleBits[aNeedleIdx]; });
+        arReached[id] |= bits;
+    }
+}
+
+std::vector<uint32_t> Engine::m_getSweepOrder(datas::EdgeKindMask aEdgeKinds, bool& aoCyclic) const {
+    const auto nodesCount = mr_snapshot.getNodesCount();
+    std::vector<uint32_t> pendingDependencies(nodesCount, 0U);
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        const auto dependents = mr_snapshot.getDependents(id);
+        for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+            if (dependents.isFollowed(edge, aEdgeKinds)) {
+                ++pendingDependencies[*edge];
+            }
+        }
+    }
+    std::vector<uint32_t> ret;
+    ret.reserve(nodesCount);
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        if (pendingDependencies[id] == 0U) {
+            ret.push_back(id);
+        }
+    }
+    for (size_t idx = 0U; idx < ret.size(); ++idx) {
+        const auto dependents = mr_snapshot.getDependents(ret[idx]);
+        for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+            if (dependents.isFollowed(edge, aEdgeKinds) && (--pendingDependencies[*edge] == 0U)) {
+                ret.push_back(*edge);
+            }
+        }
+    }
+    aoCyclic = (ret.size() < nodesCount);
+    if (aoCyclic) {
+        for (uint32_t id = 0U; id < nodesCount; ++id) {
+            if (pendingDependencies[id] != 0U) {
+                ret.push_back(id);
+            }
+        }
+    }
+    return ret;
+}
+
+void Engine::m_walkContracted(std::vector<uint32_t>& arQueue, std::vector<uint8_t>& arVisited) const {
+    const auto kinds = mr_snapshot.getContractedKinds();
+    for (size_t idx = 0U; idx < arQueue.size(); ++idx) {
+        const auto id = arQueue[idx];
+        if (mr_snapshot.getType(id) != datas::TargetType::OBJECT) {
+            for (const auto dependent : mr_snapshot.getContractedDependents(id)) {
+                if (arVisited[dependent] == 0U) {
+                    arVisited[dependent] = 1U;
+                    arQueue.push_back(dependent);
+                }
+            }
+        } else {
+            // an object seed has no contracted row, its dependents are taken from the full graph
+            const auto dependents = mr_snapshot.getDependents(id);
+            for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+                const auto dependent = *edge;
+                if ((arVisited[dependent] == 0U) && dependents.isFollowed(edge, kinds)) {
+                    arVisited[dependent] = 1U;
+                    arQueue.push_back(dependent);
+                }
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> Engine::m_getSeeds(const std::vector<std::string>& aSourcePaths, const datas::SeedOptions& aSeedOptions) const {
+    if (aSeedOptions.match != datas::PathMatch::SUFFIX) {
+        return m_getSeedsBySubString(aSourcePaths);
+    }
+    std::vector<uint32_t> ret;
+    for (const auto& file : aSourcePaths) {
+        const auto ids = utils::paths::resolveBySuffix<uint32_t>(
+            file,
+            aSeedOptions,
+            [this](const std::string& aSuffix) { return mr_snapshot.findBySuffix(aSuffix); },
+            [this](uint32_t aId) { return mr_snapshot.getPath(aId); });
+        ret.insert(ret.end(), ids.begin(), ids.end());
+    }
+    std::sort(ret.begin(), ret.end());
+    ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+    return ret;
+}
+
+std::vector<uint32_t> Engine::m_getSeedsBySubString(const std::vector<std::string>& aSourcePaths) const {
+    const utils::SubStringMatcher matcher(aSourcePaths);
+    std::vector<uint32_t> ret;
+    const auto nodesCount = mr_snapshot.getNodesCount();
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        if (matcher.isMatching(mr_snapshot.getPath(id))) {
+            ret.push_back(id);
+        }
+    }
+    return ret;
+}
+
+}  // namespace graph
+}  // namespace kunai
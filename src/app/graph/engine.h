@@ -0,0 +1,81 @@
+#pragma once
+
+/*
+ * Engine - native query engine over a graph Snapshot
+ *
+ * Answers the same queries as the DataBase, with the same semantic,
+ * by walking the memory mapped CSR arrays.
+ * Queries not asking for objects walk the contracted graph of the snapshot.
+ * With a Closure index, pointed libraries and binaries are obtained
+ * by or-ing the precomputed bitmaps of the seeds instead of a traversal.
+ */
+
+#include <app/headers/defs.hpp>
+#include <app/graph/closure.h>
+#include <app/graph/snapshot.h>
+#include <app/utils/path_matcher.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace kunai {
+namespace graph {
+
+class Engine {
+private:
+    const Snapshot& mr_snapshot;
+    const Closure* mp_closure{nullptr};
+
+public:
+    explicit Engine(const Snapshot& arSnapshot, const Closure* apClosure = nullptr);
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Queries
+    // apMatcher filters the paths, nullptr for all
+    datas::TargetsByType getAllTargets(datas::TargetTypeMask aTypeMask, const utils::PathMatcher* apMatcher = nullptr) const;
+    // one traversal for all the requested types
+    datas::TargetsByType getPointedTargets(
+        const std::vector<std::string>& sourcePaths,
+        datas::TargetTypeMask aTypeMask,
+        const datas::SeedOptions& aSeedOptions = {},
+        const datas::TraversalOptions& aTraversalOptions = {},
+        const utils::PathMatcher* apMatcher = nullptr) const;
+    // same targets as getPointedTargets, the nearest first : a BFS on the full graph gives aOnLevel the
+    // targets of each depth (count of hops from the seeds) as soon as it reaches them, unordered
+    void forEachPointedLevel(
+        const std::vector<std::string>& sourcePaths,
+        datas::TargetTypeMask aTypeMask,
+        const datas::SeedOptions& aSeedOptions,
+        const datas::TraversalOptions& aTraversalOptions,
+        const utils::PathMatcher* apMatcher,
+        const std::function<void(uint32_t aDepth, const std::vector<uint32_t>& aNodeIds)>& aOnLevel) const;
+    // same results as getPointedTargets for each query. the queries following the same
+    // edge kinds are run by 64 : a node holds a word whose bit q is set if the query q reaches it,
+    // and one sweep of the graph in dependency order propagates the 64 queries together
+    std::vector<datas::TargetsByType> getPointedTargetsBatch(const std::vector<datas::PointedQuery>& aQueries, const datas::SeedOptions& aSeedOptions = {}) const;
+
+private:
+    // nodes matching one of the source paths
+    std::vector<uint32_t> m_getSeeds(const std::vector<std::string>& aSourcePaths, const datas::SeedOptions& aSeedOptions) const;
+    // nodes whose path contains one of the source paths (case insensitive, like the sql LIKE)
+    std::vector<uint32_t> m_getSeedsBySubString(const std::vector<std::string>& aSourcePaths) const;
+
+    // BFS from the nodes of arQueue on the contracted graph, the reached nodes are appended to arQueue
+    void m_walkContracted(std::vector<uint32_t>& arQueue, std::vector<uint8_t>& arVisited) const;
+    // bit lane of arReached is set on the seeds of the files of the lane
+    void m_seedLanes(const std::vector<const std::vector<std::string>*>& aLaneFiles, const datas::SeedOptions& aSeedOptions, std::vector<uint64_t>& arReached) const;
+    // nodes ordered before their dependents through the followed edges.
+    // aoCyclic is true if some nodes are in a cycle, they are then at the end in id order
+    std::vector<uint32_t> m_getSweepOrder(datas::EdgeKindMask aEdgeKinds, bool& aoCyclic) const;
+    // pointed libraries or binaries from the closure index
+    datas::TargetsByType m_getPointedTargetsFromClosure(
+        const std::vector<uint32_t>& aSeeds,
+        datas::TargetTypeMask aTypeMask,
+        const utils::PathMatcher* apMatcher) const;
+};
+
+}  // namespace graph
+}  // namespace kunai
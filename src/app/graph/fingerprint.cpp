@@ -0,0 +1,139 @@
+#include "fingerprint.h"
+
+#include <app/utils/paths.h>
+#include <app/utils/file_hash.h>
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace graph {
+
+// aFunctor(idx) for each idx of [0, aCount), spread over aThreadsCount threads
+static void forEachParallel(size_t aCount, uint32_t aThreadsCount, const std::function<void(size_t)>& aFunctor) {
+    std::atomic<size_t> next{0U};
+    auto worker = [&next, aCount, &aFunctor]() {
+        for (size_t idx = next++; idx < aCount; idx = next++) {
+            aFunctor(idx);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1U; t < std::min(aThreadsCount, static_cast<uint32_t>(aCount)); ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::vector<Fingerprint::Entry> Fingerprint::compute(
+    const Snapshot& aSnapshot,
+    const fs::path& aBuildDir,
+    const std::vector<uint32_t>& aTargets,
+    datas::EdgeKindMask aEdgeKinds,
+    utils::HashCache& arCache,
+    uint32_t aThreadsCount) {
+    std::vector<Entry> ret;
+    if (aTargets.empty()) {
+        return ret;
+    }
+    if (aThreadsCount == 0U) {
+        aThreadsCount = std::max(1U, std::thread::hardware_concurrency());
+    }
+    const auto nodesCount = aSnapshot.getNodesCount();
+
+    // forward closures, the hashed files of each target
+    std::vector<std::vector<uint32_t>> closures(aTargets.size());
+    forEachParallel(aTargets.size(), aThreadsCount, [&](size_t aIdx) {
+        std::vector<uint8_t> visited(nodesCount, 0U);
+        std::vector<uint32_t> queue{aTargets[aIdx]};
+        visited[aTargets[aIdx]] = 1U;
+        for (size_t q = 0U; q < queue.size(); ++q) {
+            const auto dependencies = aSnapshot.getDependencies(queue[q]);
+            for (const auto* edge = dependencies.begin(); edge != dependencies.end(); ++edge) {
+                if ((visited[*edge] == 0U) && dependencies.isFollowed(edge, aEdgeKinds)) {
+                    visited[*edge] = 1U;
+                    queue.push_back(*edge);
+                    if (datas::hasType(HASHED_TYPES, aSnapshot.getType(*edge))) {
+                        closures[aIdx].push_back(*edge);
+                    }
+                }
+            }
+        }
+    });
+
+    // each file of the closures is hashed once
+    std::vector<uint32_t> fileIdxs(nodesCount, UINT32_MAX);
+    std::vector<uint32_t> files;
+    for (const auto& closure : closures) {
+        for (const auto id : closure) {
+            if (fileIdxs[id] == UINT32_MAX) {
+                fileIdxs[id] = static_cast<uint32_t>(files.size());
+                files.push_back(id);
+            }
+        }
+    }
+    std::error_code ec;
+    const auto buildDir = fs::absolute(aBuildDir, ec).lexically_normal();
+    std::vector<std::string> absPaths(files.size() + 1U);  // the manifest last
+    absPaths.back() = (buildDir / "build.ninja").string();
+    std::vector<std::string> relPaths(files.size());
+    std::vector<std::string> hashes(absPaths.size());
+    std::vector<utils::FileStamp> stamps(absPaths.size());
+    std::vector<uint8_t> hashed(absPaths.size(), 0U);  // not found in the cache
+    forEachParallel(absPaths.size(), aThreadsCount, [&](size_t aIdx) {
+        if (aIdx < files.size()) {
+            absPaths[aIdx] = utils::paths::toAbsolute(buildDir, aSnapshot.getPath(files[aIdx]));
+            relPaths[aIdx] = fs::path(absPaths[aIdx]).lexically_relative(buildDir).generic_string();
+            if (relPaths[aIdx].empty()) {
+                relPaths[aIdx] = absPaths[aIdx];  // not on the build dir root name (ex : another windows drive)
+            }
+        }
+        stamps[aIdx] = utils::FileStamp::get(absPaths[aIdx]);
+        if (stamps[aIdx].exists && !arCache.find(absPaths[aIdx], stamps[aIdx], hashes[aIdx])) {
+            hashes[aIdx] = utils::FileHash::compute(absPaths[aIdx], arCache.getAlgo());
+            hashed[aIdx] = hashes[aIdx].empty() ? 0U : 1U;
+        }
+    });
+    for (size_t idx = 0U; idx < absPaths.size(); ++idx) {
+        if (hashed[idx] != 0U) {
+            arCache.set(absPaths[idx], stamps[idx], hashes[idx]);
+        }
+    }
+    arCache.retain(absPaths);  // the files gone from the graph would stay forever
+    const auto& manifestHash = hashes.back();
+
+    // digest of the (relative path, hash) of the files, in path order
+    ret.resize(aTargets.size());
+    forEachParallel(aTargets.size(), aThreadsCount, [&](size_t aIdx) {
+        auto& entry = ret[aIdx];
+        entry.nodeId = aTargets[aIdx];
+        entry.path = aSnapshot.getPath(entry.nodeId);
+        std::vector<uint32_t> closure;
+        closure.reserve(closures[aIdx].size());
+        for (const auto id : closures[aIdx]) {
+            closure.push_back(fileIdxs[id]);
+        }
+        std::sort(closure.begin(), closure.end(), [&relPaths](uint32_t a, uint32_t b) { return relPaths[a] < relPaths[b]; });
+        static constexpr std::string_view missing{"missing"};
+        utils::Hasher hasher(arCache.getAlgo());
+        hasher.update(reinterpret_cast<const uint8_t*>(manifestHash.data()), manifestHash.size());
+        hasher.update(reinterpret_cast<const uint8_t*>("\n"), 1U);
+        for (const auto idx : closure) {
+            const std::string_view content = hashes[idx].empty() ? missing : std::string_view(hashes[idx]);
+            hasher.update(reinterpret_cast<const uint8_t*>(relPaths[idx].data()), relPaths[idx].size() + 1U);  // with the '\0' separator
+            hasher.update(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+            hasher.update(reinterpret_cast<const uint8_t*>("\n"), 1U);
+        }
+        entry.digest = hasher.finalize();
+    });
+    return ret;
+}
+
+}  // namespace graph
+}  // namespace kunai
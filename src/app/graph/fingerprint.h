@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+ * Fingerprint - digest of the files a target is made of, for test result caching
+ *
+ * The forward closure of a target (its dependencies, transitively) reaches the
+ * sources, headers, libraries and inputs it's built from. Their content hashes,
+ * ordered by path, are hashed together into one digest : while it's unchanged,
+ * the result of a previous run of the target can be reused.
+ * The paths are taken relative to the build dir, so the digest doesn't depend on
+ * where the tree is checked out, and a missing file is hashed as missing.
+ * The commands and flags aren't in the graph : the hash of build.ninja, which holds
+ * them, is folded in every digest, any change of it changes all the digests.
+ * The files of all the closures are hashed once, over a pool of threads,
+ * and a file with an unchanged stamp keeps its cached hash.
+ */
+
+#include <app/graph/snapshot.h>
+#include <app/utils/hash_cache.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace kunai {
+namespace graph {
+
+class Fingerprint {
+public:
+    // types of the nodes whose content is hashed
+    static constexpr datas::TargetTypeMask HASHED_TYPES{
+        datas::toMask(datas::TargetType::SOURCE) | datas::toMask(datas::TargetType::HEADER) |  //
+        datas::toMask(datas::TargetType::LIBRARY) | datas::toMask(datas::TargetType::INPUT)};
+
+    struct Entry {
+        uint32_t nodeId{};
+        std::string_view path;  // in the snapshot
+        std::string digest;
+    };
+
+    // one entry by target of aTargets, in aTargets order. the relative paths are relative to aBuildDir.
+    // arCache gives the hashes of the unchanged files and gets the new ones, it keeps only the files of this run.
+    // aThreadsCount at 0 means the hardware concurrency
+    static std::vector<Entry> compute(
+        const Snapshot& aSnapshot,
+        const std::filesystem::path& aBuildDir,
+        const std::vector<uint32_t>& aTargets,
+        datas::EdgeKindMask aEdgeKinds,
+        utils::HashCache& arCache,
+        uint32_t aThreadsCount = 0U);
+};
+
+}  // namespace graph
+}  // namespace kunai
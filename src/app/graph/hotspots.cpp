@@ -0,0 +1,112 @@
+#include "hotspots.h"
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+namespace kunai {
+namespace graph {
+
+bool Hotspots::isTest(const Snapshot& aSnapshot, uint32_t aNodeId) {
+    if (aSnapshot.getType(aNodeId) != datas::TargetType::BINARY) {
+        return false;
+    }
+    auto name = aSnapshot.getPath(aNodeId);
+    const auto slash = name.find_last_of('/');
+    if (slash != std::string_view::npos) {
+        name.remove_prefix(slash + 1U);
+    }
+    static constexpr std::string_view needle{"test"};
+    const auto it = std::search(name.begin(), name.end(), needle.begin(), needle.end(), [](char a, char b) {  //
+        return (((a >= 'A') && (a <= 'Z')) ? static_cast<char>(a - 'A' + 'a') : a) == b;
+    });
+    return it != name.end();
+}
+
+std::vector<Hotspots::Entry> Hotspots::compute(
+    const Snapshot& aSnapshot,
+    datas::TargetTypeMask aTypeMask,
+    const std::vector<double>& aCosts,
+    datas::EdgeKindMask aEdgeKinds,
+    uint32_t aThreadsCount) {
+    const auto nodesCount = aSnapshot.getNodesCount();
+    std::vector<Entry> ret;
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        const auto type = aSnapshot.getType(id);
+        if (((type == datas::TargetType::SOURCE) || (type == datas::TargetType::HEADER)) && datas::hasType(aTypeMask, type)) {
+            Entry entry;
+            entry.nodeId = id;
+            entry.path = aSnapshot.getPath(id);
+            ret.push_back(entry);
+        }
+    }
+    if (ret.empty()) {
+        return ret;
+    }
+
+    // the test flag is computed once, not at each traversal
+    std::vector<uint8_t> tests(nodesCount, 0U);
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        tests[id] = isTest(aSnapshot, id) ? 1U : 0U;
+    }
+    const bool hasCosts = (aCosts.size() == nodesCount);
+
+    if (aThreadsCount == 0U) {
+        aThreadsCount = std::max(1U, std::thread::hardware_concurrency());
+    }
+    aThreadsCount = std::min(aThreadsCount, static_cast<uint32_t>(ret.size()));
+
+    std::atomic<size_t> next{0U};
+    auto worker = [&]() {
+        // a node is visited by the current traversal if its mark is the current generation
+        std::vector<uint32_t> marks(nodesCount, 0U);
+        std::vector<uint32_t> queue;
+        uint32_t generation = 0U;
+        for (size_t idx = next++; idx < ret.size(); idx = next++) {
+            auto& entry = ret[idx];
+            ++generation;
+            queue.clear();
+            queue.push_back(entry.nodeId);
+            marks[entry.nodeId] = generation;
+            for (size_t q = 0U; q < queue.size(); ++q) {
+                const auto id = queue[q];
+                switch (aSnapshot.getType(id)) {
+                    case datas::TargetType::OBJECT: ++entry.objects; break;
+                    case datas::TargetType::LIBRARY: ++entry.libraries; break;
+                    case datas::TargetType::BINARY: ++entry.binaries; break;
+                    default: break;
+                }
+                entry.tests += tests[id];
+                if (hasCosts) {
+                    entry.cost += aCosts[id];
+                }
+                const auto dependents = aSnapshot.getDependents(id);
+                for (const auto* edge = dependents.begin(); edge != dependents.end(); ++edge) {
+                    if (!dependents.isFollowed(edge, aEdgeKinds)) {
+                        continue;
+                    }
+                    if (q == 0U) {
+                        ++entry.fanIn;
+                    }
+                    if (marks[*edge] != generation) {
+                        marks[*edge] = generation;
+                        queue.push_back(*edge);
+                    }
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1U; t < aThreadsCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return ret;
+}
+
+}  // namespace graph
+}  // namespace kunai
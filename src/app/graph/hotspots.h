@@ -0,0 +1,50 @@
+#pragma once
+
+/*
+ * Hotspots - reverse reach of the sources and headers of a graph Snapshot
+ *
+ * For each source or header, counts what a change of it touches :
+ *   - fan-in  : direct dependents (ex : the objects including a header)
+ *   - objects, libraries, binaries and tests (binaries named like *test*) reached
+ *   - cost    : sum of the last build durations (.ninja_log) of the reached nodes
+ * The traversals are independent and spread over a pool of threads.
+ */
+
+#include <app/graph/snapshot.h>
+
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+namespace kunai {
+namespace graph {
+
+class Hotspots {
+public:
+    struct Entry {
+        uint32_t nodeId{};
+        std::string_view path;  // in the snapshot
+        uint32_t fanIn{};
+        uint32_t objects{};
+        uint32_t libraries{};
+        uint32_t binaries{};
+        uint32_t tests{};
+        double cost{};  // ms
+    };
+
+    // computed for the nodes of the types of aTypeMask (sources and/or headers).
+    // aCosts is empty or gives the build duration of each node, in ms.
+    // aThreadsCount at 0 means the hardware concurrency
+    static std::vector<Entry> compute(
+        const Snapshot& aSnapshot,
+        datas::TargetTypeMask aTypeMask,
+        const std::vector<double>& aCosts,
+        datas::EdgeKindMask aEdgeKinds = datas::DEFAULT_EDGE_KINDS,
+        uint32_t aThreadsCount = 0U);
+
+    // true for a binary whose file name contains "test", not case sensitive
+    static bool isTest(const Snapshot& aSnapshot, uint32_t aNodeId);
+};
+
+}  // namespace graph
+}  // namespace kunai
@@ -0,0 +1,45 @@
+#include "rebuild_set.h"
+
+namespace kunai {
+namespace graph {
+
+std::vector<uint32_t> RebuildSet::compute(const Snapshot& aSnapshot, const std::vector<uint32_t>& aSelected) {
+    const auto nodesCount = aSnapshot.getNodesCount();
+    std::vector<uint8_t> selected(nodesCount, 0U);
+    for (const auto id : aSelected) {
+        selected[id] = 1U;
+    }
+
+    // one forward walk from all the selected nodes : a node reached through at least
+    // one edge is built by a selected node. the selected nodes start unvisited,
+    // so that a selected node is only marked if another one needs it
+    std::vector<uint8_t> built(nodesCount, 0U);
+    std::vector<uint32_t> queue;
+    auto pushDependencies = [&aSnapshot, &built, &queue](uint32_t aId) {
+        const auto dependencies = aSnapshot.getDependencies(aId);
+        for (const auto* edge = dependencies.begin(); edge != dependencies.end(); ++edge) {
+            if ((built[*edge] == 0U) && dependencies.isFollowed(edge, BUILD_EDGE_KINDS)) {
+                built[*edge] = 1U;
+                queue.push_back(*edge);
+            }
+        }
+    };
+    for (const auto id : aSelected) {
+        pushDependencies(id);
+    }
+    for (size_t idx = 0U; idx < queue.size(); ++idx) {
+        pushDependencies(queue[idx]);
+    }
+
+    std::vector<uint32_t> ret;
+    for (const auto id : aSelected) {
+        if ((built[id] == 0U) && (selected[id] != 0U)) {
+            ret.push_back(id);
+            selected[id] = 0U;  // once, even if given twice
+        }
+    }
+    return ret;
+}
+
+}  // namespace graph
+}  // namespace kunai
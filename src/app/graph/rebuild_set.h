@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+ * RebuildSet - minimal ninja outputs covering the affected targets
+ *
+ * Ninja builds the inputs of an output before it : a selected output reached
+ * from another selected output through the build edges (explicit, implicit
+ * or order-only) is built anyway and is removed from the set.
+ * `ninja <set>` then builds the same slice with the fewest targets.
+ */
+
+#include <app/graph/snapshot.h>
+
+#include <vector>
+#include <cstdint>
+
+namespace kunai {
+namespace graph {
+
+class RebuildSet {
+public:
+    // edges ninja follows to build the inputs of an output
+    static constexpr datas::EdgeKindMask BUILD_EDGE_KINDS{
+        datas::toMask(datas::EdgeKind::EXPLICIT) | datas::toMask(datas::EdgeKind::IMPLICIT) | datas::toMask(datas::EdgeKind::ORDER_ONLY)};
+
+    // the nodes of aSelected not built by another node of aSelected, in aSelected order
+    static std::vector<uint32_t> compute(const Snapshot& aSnapshot, const std::vector<uint32_t>& aSelected);
+};
+
+}  // namespace graph
+}  // namespace kunai
@@ -0,0 +1,365 @@
+#include "snapshot.h"
+
+#include <app/model/model.h>
+#include <app/utils/paths.h>
+
+#include <limits>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace graph {
+
+constexpr char Snapshot::MAGIC[8];
+
+static uint64_t alignOn8(uint64_t aOffset) {
+    return (aOffset + 7U) & ~static_cast<uint64_t>(7U);
+}
+
+template <typename T>
+static void writeSection(std::ofstream& arFile, uint64_t aOffset, const std::vector<T>& aDatas) {
+    arFile.seekp(static_cast<std::streamoff>(aOffset));
+    if (!aDatas.empty()) {
+        arFile.write(reinterpret_cast<const char*>(aDatas.data()), static_cast<std::streamsize>(aDatas.size() * sizeof(T)));
+    }
+}
+
+// the trailing sections can be empty, the file then ends before their offset
+static void padTo(std::ofstream& arFile, uint64_t aSize) {
+    arFile.seekp(0, std::ios::end);
+    const auto size = static_cast<uint64_t>(arFile.tellp());
+    if (size < aSize) {
+        const std::vector<char> zeros(static_cast<size_t>(aSize - size), 0);
+        arFile.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+}
+
+struct Edge {
+    uint32_t key;
+    uint32_t value;
+    uint8_t kinds;
+};
+
+// Build the CSR offsets/edges/kinds of one direction from the (key, value) edges
+static void buildCsr(
+    uint32_t aNodesCount,
+    std::vector<Edge>& arEdges,
+    std::vector<uint32_t>& aoOffsets,
+    std::vector<uint32_t>& aoEdges,
+    std::vector<uint8_t>& aoKinds) {
+    // sorted first, so the values of each row come out sorted
+    std::sort(arEdges.begin(), arEdges.end(), [](const Edge& a, const Edge& b) {  //
+        return (a.key < b.key) || ((a.key == b.key) && (a.value < b.value));
+    });
+    aoOffsets.assign(aNodesCount + 1U, 0U);
+    for (const auto& e : arEdges) {
+        ++aoOffsets[e.key + 1U];
+    }
+    for (uint32_t i = 0U; i < aNodesCount; ++i) {
+        aoOffsets[i + 1U] += aoOffsets[i];
+    }
+    aoEdges.resize(arEdges.size());
+    aoKinds.resize(arEdges.size());
+    std::vector<uint32_t> cursors(aoOffsets.begin(), aoOffsets.end() - 1);
+    for (const auto& e : arEdges) {
+        const auto idx = cursors[e.key]++;
+        aoEdges[idx] = e.value;
+        aoKinds[idx] = e.kinds;
+    }
+}
+
+bool Snapshot::write(const DataBase& aDb, const std::string& aStamp, const fs::path& aFilePath, std::string& aoError) {
+    // Nodes
+    std::unordered_map<int64_t, uint32_t> dbIdToNodeId;
+    std::vector<uint8_t> types;
+    std::vector<uint64_t> pathOffsets{0U};
+    std::string paths;
+    aDb.forEachTarget([&](int64_t aId, const char* aPath, datas::TargetType aType) {
+        dbIdToNodeId[aId] = static_cast<uint32_t>(types.size());
+        types.push_back(static_cast<uint8_t>(aType));
+        if (aPath != nullptr) {
+            paths += aPath;
+        }
+        pathOffsets.push_back(paths.size());
+    });
+    const auto nodesCount = static_cast<uint32_t>(types.size());
+
+    // Edges. a link goes from the target to its dependency
+    std::vector<Edge> fwdPairs;
+    aDb.forEachLink([&](int64_t aFromId, int64_t aToId, datas::EdgeKindMask aKinds) {
+        const auto itFrom = dbIdToNodeId.find(aFromId);
+        const auto itTo = dbIdToNodeId.find(aToId);
+        if (itFrom != dbIdToNodeId.end() && itTo != dbIdToNodeId.end()) {
+            fwdPairs.push_back({itFrom->second, itTo->second, static_cast<uint8_t>(aKinds)});
+        }
+    });
+    std::vector<Edge> revPairs;
+    revPairs.reserve(fwdPairs.size());
+    for (const auto& e : fwdPairs) {
+        revPairs.push_back({e.value, e.key, e.kinds});
+    }
+
+    std::vector<uint32_t> fwdOffsets, fwdEdges, revOffsets, revEdges;
+    std::vector<uint8_t> fwdKinds, revKinds;
+    buildCsr(nodesCount, fwdPairs, fwdOffsets, fwdEdges, fwdKinds);
+    buildCsr(nodesCount, revPairs, revOffsets, revEdges, revKinds);
+
+    // Contracted reverse adjacency. the dependents of a node are collected
+    // through the chains of objects, each node is added once per row
+    std::vector<uint32_t> contractedOffsets{0U};
+    std::vector<uint32_t> contractedEdges;
+    {
+        constexpr auto kinds = datas::DEFAULT_EDGE_KINDS;
+        constexpr auto none = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> lastRow(nodesCount, none);
+        std::vector<uint32_t> pending;
+        contractedOffsets.reserve(nodesCount + 1U);
+        for (uint32_t id = 0U; id < nodesCount; ++id) {
+            const auto rowStart = contractedEdges.size();
+            if (static_cast<datas::TargetType>(types[id]) != datas::TargetType::OBJECT) {
+                pending.push_back(id);
+                lastRow[id] = id;
+                while (!pending.empty()) {
+                    const auto current = pending.back();
+                    pending.pop_back();
+                    for (auto idx = revOffsets[current]; idx < revOffsets[current + 1U]; ++idx) {
+                        const auto dependent = revEdges[idx];
+                        if (((revKinds[idx] & kinds) == 0U) || (lastRow[dependent] == id)) {
+                            continue;
+                        }
+                        lastRow[dependent] = id;
+                        if (static_cast<datas::TargetType>(types[dependent]) == datas::TargetType::OBJECT) {
+                            pending.push_back(dependent);
+                        } else {
+                            contractedEdges.push_back(dependent);
+                        }
+                    }
+                }
+                std::sort(contractedEdges.begin() + static_cast<std::ptrdiff_t>(rowStart), contractedEdges.end());
+            }
+            contractedOffsets.push_back(static_cast<uint32_t>(contractedEdges.size()));
+        }
+    }
+
+    // Suffix order
+    std::vector<uint32_t> suffixOrder(nodesCount);
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        suffixOrder[id] = id;
+    }
+    auto getPath = [&](uint32_t aId) {
+        return std::string_view(paths.data() + pathOffsets[aId], static_cast<size_t>(pathOffsets[aId + 1U] - pathOffsets[aId]));
+    };
+    std::sort(suffixOrder.begin(), suffixOrder.end(), [&](uint32_t a, uint32_t b) {
+        const auto pa = getPath(a);
+        const auto pb = getPath(b);
+        return std::lexicographical_compare(pa.rbegin(), pa.rend(), pb.rbegin(), pb.rend());
+    });
+
+    // Header
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.nodesCount = nodesCount;
+    header.edgesCount = static_cast<uint32_t>(fwdEdges.size());
+    header.contractedEdgesCount = static_cast<uint32_t>(contractedEdges.size());
+    header.contractedKinds = datas::DEFAULT_EDGE_KINDS;
+    std::strncpy(header.stamp, aStamp.c_str(), sizeof(header.stamp) - 1U);
+    header.typesOffset = alignOn8(sizeof(Header));
+    header.pathOffsetsOffset = alignOn8(header.typesOffset + types.size());
+    header.pathsOffset = alignOn8(header.pathOffsetsOffset + pathOffsets.size() * sizeof(uint64_t));
+    header.revOffsetsOffset = alignOn8(header.pathsOffset + paths.size());
+    header.revEdgesOffset = alignOn8(header.revOffsetsOffset + revOffsets.size() * sizeof(uint32_t));
+    header.fwdOffsetsOffset = alignOn8(header.revEdgesOffset + revEdges.size() * sizeof(uint32_t));
+    header.fwdEdgesOffset = alignOn8(header.fwdOffsetsOffset + fwdOffsets.size() * sizeof(uint32_t));
+    header.suffixOrderOffset = alignOn8(header.fwdEdgesOffset + fwdEdges.size() * sizeof(uint32_t));
+    header.revKindsOffset = alignOn8(header.suffixOrderOffset + suffixOrder.size() * sizeof(uint32_t));
+    header.fwdKindsOffset = alignOn8(header.revKindsOffset + revKinds.size());
+    header.contractedOffsetsOffset = alignOn8(header.fwdKindsOffset + fwdKinds.size());
+    header.contractedEdgesOffset = alignOn8(header.contractedOffsetsOffset + contractedOffsets.size() * sizeof(uint32_t));
+
+    // Written aside then renamed, so a reader never maps a partial file.
+    // the temporary file is our own : another writer can't truncate it once renamed and mapped
+    const auto tmpFilePath = utils::paths::getTmpPath(aFilePath);
+    {
+        std::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            aoError = "Cannot open file: " + tmpFilePath.string();
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        writeSection(file, header.typesOffset, types);
+        writeSection(file, header.pathOffsetsOffset, pathOffsets);
+        file.seekp(static_cast<std::streamoff>(header.pathsOffset));
+        file.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+        writeSection(file, header.revOffsetsOffset, revOffsets);
+        writeSection(file, header.revEdgesOffset, revEdges);
+        writeSection(file, header.fwdOffsetsOffset, fwdOffsets);
+        writeSection(file, header.fwdEdgesOffset, fwdEdges);
+        writeSection(file, header.suffixOrderOffset, suffixOrder);
+        writeSection(file, header.revKindsOffset, revKinds);
+        writeSection(file, header.fwdKindsOffset, fwdKinds);
+        writeSection(file, header.contractedOffsetsOffset, contractedOffsets);
+        writeSection(file, header.contractedEdgesOffset, contractedEdges);
+        padTo(file, header.contractedEdgesOffset + contractedEdges.size() * sizeof(uint32_t));
+        if (!file.good()) {
+            aoError = "Cannot write file: " + tmpFilePath.string();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmpFilePath, aFilePath, ec);
+    if (ec) {
+        aoError = "Cannot replace " + aFilePath.string() + " : " + ec.message();
+        fs::remove(tmpFilePath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::pair<std::unique_ptr<Snapshot>, std::string> Snapshot::create(const fs::path& aFilePath) {
+    auto pRet = std::make_unique<Snapshot>();
+    std::string error;
+    if (!pRet->m_open(aFilePath)) {
+        error = pRet->getError();
+        pRet.reset();
+    }
+    return std::make_pair(std::move(pRet), error);
+}
+
+std::string Snapshot::getError() const {
+    return m_error.str();
+}
+
+std::string Snapshot::getStamp() const {
+    return std::string(mp_header->stamp, strnlen(mp_header->stamp, sizeof(mp_header->stamp)));
+}
+
+uint32_t Snapshot::getNodesCount() const {
+    return mp_header->nodesCount;
+}
+
+uint32_t Snapshot::getEdgesCount() const {
+    return mp_header->edgesCount;
+}
+
+datas::TargetType Snapshot::getType(uint32_t aNodeId) const {
+    return static_cast<datas::TargetType>(mp_types[aNodeId]);
+}
+
+std::string_view Snapshot::getPath(uint32_t aNodeId) const {
+    const auto start = mp_pathOffsets[aNodeId];
+    return std::string_view(mp_paths + start, static_cast<size_t>(mp_pathOffsets[aNodeId + 1U] - start));
+}
+
+Snapshot::NodeRange Snapshot::getDependents(uint32_t aNodeId) const {
+    return {mp_revEdges + mp_revOffsets[aNodeId], mp_revEdges + mp_revOffsets[aNodeId + 1U], mp_revKinds + mp_revOffsets[aNodeId]};
+}
+
+Snapshot::NodeRange Snapshot::getDependencies(uint32_t aNodeId) const {
+    return {mp_fwdEdges + mp_fwdOffsets[aNodeId], mp_fwdEdges + mp_fwdOffsets[aNodeId + 1U], mp_fwdKinds + mp_fwdOffsets[aNodeId]};
+}
+
+datas::EdgeKindMask Snapshot::getContractedKinds() const {
+    return mp_header->contractedKinds;
+}
+
+Snapshot::NodeRange Snapshot::getContractedDependents(uint32_t aNodeId) const {
+    return {mp_contractedEdges + mp_contractedOffsets[aNodeId], mp_contractedEdges + mp_contractedOffsets[aNodeId + 1U], nullptr};
+}
+
+std::vector<uint32_t> Snapshot::findBySuffix(std::string_view aSuffix) const {
+    std::vector<uint32_t> ret;
+    if (aSuffix.empty()) {
+        return ret;
+    }
+    // first path whose reversed form is not lower than the reversed suffix
+    const auto* end = mp_suffixOrder + mp_header->nodesCount;
+    const auto* it = std::lower_bound(mp_suffixOrder, end, aSuffix, [this](uint32_t aId, std::string_view aValue) {
+        const auto path = getPath(aId);
+        return std::lexicographical_compare(path.rbegin(), path.rend(), aValue.rbegin(), aValue.rend());
+    });
+    // then all the paths ending with the suffix are contiguous
+    for (; it != end; ++it) {
+        const auto path = getPath(*it);
+        if ((path.size() < aSuffix.size()) || (path.compare(path.size() - aSuffix.size(), aSuffix.size(), aSuffix) != 0)) {
+            break;
+        }
+        if ((path.size() == aSuffix.size()) || (path[path.size() - aSuffix.size() - 1U] == '/')) {
+            ret.push_back(*it);
+        }
+    }
+    return ret;
+}
+
+bool Snapshot::m_open(const fs::path& aFilePath) {
+    auto tmp_pFile = utils::MappedFile::create(aFilePath);
+    if (tmp_pFile.first == nullptr) {
+        m_error << tmp_pFile.second;
+        return false;
+    }
+    mp_file = std::move(tmp_pFile.first);
+
+    const auto* datas = mp_file->getDatas();
+    const auto size = static_cast<uint64_t>(mp_file->size());
+    if (size < sizeof(Header)) {
+        m_error << "Truncated snapshot: " << aFilePath.string();
+        return false;
+    }
+    mp_header = reinterpret_cast<const Header*>(datas);
+    if (std::memcmp(mp_header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        m_error << "Invalid snapshot signature: " << aFilePath.string();
+        return false;
+    }
+    if (mp_header->version != VERSION) {
+        m_error << "Unsupported snapshot version: " << std::to_string(mp_header->version);
+        return false;
+    }
+
+    // every section must be inside the file
+    const uint64_t nodes = mp_header->nodesCount;
+    const uint64_t edges = mp_header->edgesCount;
+    const uint64_t contracted = mp_header->contractedEdgesCount;
+    const bool sectionsOk = (mp_header->typesOffset + nodes <= size)                  //
+        && (mp_header->pathOffsetsOffset + (nodes + 1U) * sizeof(uint64_t) <= size)  //
+        && (mp_header->revOffsetsOffset + (nodes + 1U) * sizeof(uint32_t) <= size)   //
+        && (mp_header->revEdgesOffset + edges * sizeof(uint32_t) <= size)            //
+        && (mp_header->fwdOffsetsOffset + (nodes + 1U) * sizeof(uint32_t) <= size)   //
+        && (mp_header->fwdEdgesOffset + edges * sizeof(uint32_t) <= size)            //
+        && (mp_header->suffixOrderOffset + nodes * sizeof(uint32_t) <= size)         //
+        && (mp_header->revKindsOffset + edges <= size)                               //
+        && (mp_header->fwdKindsOffset + edges <= size)                               //
+        && (mp_header->contractedOffsetsOffset + (nodes + 1U) * sizeof(uint32_t) <= size)  //
+        && (mp_header->contractedEdgesOffset + contracted * sizeof(uint32_t) <= size);
+    if (!sectionsOk) {
+        m_error << "Truncated snapshot: " << aFilePath.string();
+        return false;
+    }
+
+    mp_types = datas + mp_header->typesOffset;
+    mp_pathOffsets = reinterpret_cast<const uint64_t*>(datas + mp_header->pathOffsetsOffset);
+    mp_paths = reinterpret_cast<const char*>(datas + mp_header->pathsOffset);
+    mp_revOffsets = reinterpret_cast<const uint32_t*>(datas + mp_header->revOffsetsOffset);
+    mp_revEdges = reinterpret_cast<const uint32_t*>(datas + mp_header->revEdgesOffset);
+    mp_fwdOffsets = reinterpret_cast<const uint32_t*>(datas + mp_header->fwdOffsetsOffset);
+    mp_fwdEdges = reinterpret_cast<const uint32_t*>(datas + mp_header->fwdEdgesOffset);
+    mp_suffixOrder = reinterpret_cast<const uint32_t*>(datas + mp_header->suffixOrderOffset);
+    mp_revKinds = datas + mp_header->revKindsOffset;
+    mp_fwdKinds = datas + mp_header->fwdKindsOffset;
+    mp_contractedOffsets = reinterpret_cast<const uint32_t*>(datas + mp_header->contractedOffsetsOffset);
+    mp_contractedEdges = reinterpret_cast<const uint32_t*>(datas + mp_header->contractedEdgesOffset);
+
+    if (mp_header->pathsOffset + mp_pathOffsets[nodes] > size) {
+        m_error << "Truncated snapshot: " << aFilePath.string();
+        return false;
+    }
+    return true;
+}
+
+}  // namespace graph
+}  // namespace kunai
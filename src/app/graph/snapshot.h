@@ -0,0 +1,134 @@
+#pragma once
+
+/*
+ * Snapshot - compact binary image of the dependency graph
+ *
+ * Written next to kunai.db after each rebuild and memory mapped for queries.
+ * Nodes get dense 32 bits ids (in database id order) and both edge directions
+ * are stored in CSR form, with the EdgeKind bits of each edge aside :
+ *   - dependents   : reverse adjacency (the nodes using a node)
+ *   - dependencies : forward adjacency (the nodes used by a node)
+ *
+ * Layout (little endian, sections aligned on 8 bytes) :
+ *   Header | types u8[N] | path offsets u64[N+1] | paths char[] |
+ *   rev offsets u32[N+1] | rev edges u32[E] | fwd offsets u32[N+1] | fwd edges u32[E] |
+ *   suffix order u32[N] (node ids sorted by reversed path, for the suffix matching) |
+ *   rev kinds u8[E] | fwd kinds u8[E] |
+ *   contracted offsets u32[N+1] | contracted edges u32[C]
+ *
+ * The contracted graph is the reverse adjacency without the object nodes : a node
+ * using an object is linked to the non object dependents of this object.
+ * It's computed for the default edge kinds and used by the queries not asking for objects.
+ */
+
+#include <app/headers/defs.hpp>
+#include <app/utils/mapped_file.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace kunai {
+
+class DataBase;
+
+namespace graph {
+
+class Snapshot {
+public:
+    static constexpr char MAGIC[8] = {'K', 'U', 'N', 'A', 'I', 'C', 'S', 'R'};
+    static constexpr uint32_t VERSION = 4U;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t nodesCount;
+        uint32_t edgesCount;
+        uint32_t contractedEdgesCount;
+        uint32_t contractedKinds;  // kinds of the edges followed by the contracted graph
+        uint32_t reserved;
+        uint64_t typesOffset;
+        uint64_t pathOffsetsOffset;
+        uint64_t pathsOffset;
+        uint64_t revOffsetsOffset;
+        uint64_t revEdgesOffset;
+        uint64_t fwdOffsetsOffset;
+        uint64_t fwdEdgesOffset;
+        uint64_t suffixOrderOffset;
+        uint64_t revKindsOffset;
+        uint64_t fwdKindsOffset;
+        uint64_t contractedOffsetsOffset;
+        uint64_t contractedEdgesOffset;
+        char stamp[128];  // state of the database the snapshot was made from
+    };
+
+    struct NodeRange {
+        const uint32_t* first{nullptr};
+        const uint32_t* last{nullptr};
+        const uint8_t* kinds{nullptr};  // EdgeKind bits of each edge of the range
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        // true if the edge pointed by aIt has one of the kinds of aKinds
+        bool isFollowed(const uint32_t* aIt, datas::EdgeKindMask aKinds) const { return (kinds[aIt - first] & aKinds) != 0U; }
+    };
+
+    // Write the snapshot of the graph stored in aDb. the file is replaced atomically
+    static bool write(const DataBase& aDb, const std::string& aStamp, const std::filesystem::path& aFilePath, std::string& aoError);
+
+    // Map a snapshot file
+    static std::pair<std::unique_ptr<Snapshot>, std::string> create(const std::filesystem::path& aFilePath);
+
+private:
+    std::stringstream m_error;
+    std::unique_ptr<utils::MappedFile> mp_file;
+    const Header* mp_header{nullptr};
+    const uint8_t* mp_types{nullptr};
+    const uint64_t* mp_pathOffsets{nullptr};
+    const char* mp_paths{nullptr};
+    const uint32_t* mp_revOffsets{nullptr};
+    const uint32_t* mp_revEdges{nullptr};
+    const uint32_t* mp_fwdOffsets{nullptr};
+    const uint32_t* mp_fwdEdges{nullptr};
+    const uint32_t* mp_suffixOrder{nullptr};
+    const uint8_t* mp_revKinds{nullptr};
+    const uint8_t* mp_fwdKinds{nullptr};
+    const uint32_t* mp_contractedOffsets{nullptr};
+    const uint32_t* mp_contractedEdges{nullptr};
+
+public:
+    Snapshot() = default;
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    std::string getError() const;
+    std::string getStamp() const;
+
+    uint32_t getNodesCount() const;
+    uint32_t getEdgesCount() const;
+    datas::TargetType getType(uint32_t aNodeId) const;
+    std::string_view getPath(uint32_t aNodeId) const;
+
+    // nodes using aNodeId
+    NodeRange getDependents(uint32_t aNodeId) const;
+    // nodes used by aNodeId
+    NodeRange getDependencies(uint32_t aNodeId) const;
+
+    // edge kinds the contracted graph was computed with
+    datas::EdgeKindMask getContractedKinds() const;
+    // non object nodes using aNodeId, directly or through objects. empty for an object
+    NodeRange getContractedDependents(uint32_t aNodeId) const;
+
+    // nodes whose path is aSuffix or ends with "/" + aSuffix
+    std::vector<uint32_t> findBySuffix(std::string_view aSuffix) const;
+
+private:
+    bool m_open(const std::filesystem::path& aFilePath);
+};
+
+}  // namespace graph
+}  // namespace kunai
@@ -1,14 +1,33 @@
 #pragma once
 
 #include <set>
+#include <map>
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <filesystem>
 
 namespace kunai {
+
+namespace utils {
+class PathMatcher;
+}
+
 namespace datas {
 
 inline std::string KUNAI_DB_NAME{"kunai.db"};
+inline std::string KUNAI_DB_TMP_NAME{"kunai.db.tmp"};  // shadow database, renamed to KUNAI_DB_NAME once fully built
+inline std::string KUNAI_SNAPSHOT_NAME{"kunai.csr"};    // memory mapped graph snapshot, written after each rebuild
+inline std::string KUNAI_CLOSURE_NAME{"kunai.closure"}; // optional transitive closure index of the snapshot
+inline std::string KUNAI_STAMP_NAME{"kunai.stamp"};     // stat stamps of the build files at the last check
+inline std::string KUNAI_LOCK_NAME{"kunai.lock"};       // held by the process rebuilding the database
+inline std::string KUNAI_TELEMETRY_NAME{"kunai.perf"};  // append only timing measures, the database is never written by a query
+inline std::string KUNAI_TELEMETRY_LOCK_NAME{"kunai.perf.lock"};  // serializes the appends and the compaction of kunai.perf
+inline std::string KUNAI_SOCKET_NAME{"kunai.sock"};     // unix socket of the serve daemon, used by the clients when present
+inline std::string KUNAI_HASHES_NAME{"kunai.hashes"};   // content hashes of the fingerprinted files, by file stamp
+
+// version of the database layout (PRAGMA user_version), a database of another version is rebuilt
+inline constexpr int32_t KUNAI_SCHEMA_VERSION{4};
 
 inline std::set<std::string> SOURCE_FILE_EXTS{
     ".c",     // C source
@@ -56,5 +75,86 @@ enum class TargetType {
     INPUT
 };
 
+// Set of target types, one bit per TargetType
+using TargetTypeMask = uint32_t;
+
+inline constexpr TargetTypeMask toMask(TargetType aType) {
+    return 1U << static_cast<uint32_t>(aType);
+}
+
+inline constexpr bool hasType(TargetTypeMask aMask, TargetType aType) {
+    return (aMask & toMask(aType)) != 0U;
+}
+
+// Query results bucketed by type
+using TargetsByType = std::map<TargetType, std::vector<std::string>>;
+
+// Query backends
+enum class Backend {
+    SQLITE = 0,  // recursive queries in kunai.db
+    SNAPSHOT,    // native BFS over the memory mapped kunai.csr
+    CLOSURE      // SNAPSHOT + precomputed reach bitmaps of kunai.closure
+};
+
+// Change detection hash of build.ninja and .ninja_deps
+enum class HashAlgo {
+    FAST128 = 0,  // non cryptographic 128 bits hash, default
+    SHA1          // used by the databases without hash_algo metadata
+};
+
+// How the pointed files are matched against the graph paths
+enum class PathMatch {
+    SUBSTRING = 0,  // the path contains the file, not case sensitive
+    SUFFIX          // longest common suffix of whole path components (ex : git diff paths)
+};
+
+// Output order of the pointed targets
+enum class TargetOrder {
+    NAME = 0,  // sorted by path
+    DISTANCE,  // the nearest to the modified files first (fewest hops), streamed depth by depth
+    COST       // the cheapest last build first (.ninja_log), then by distance
+};
+
+// Origin of a link. a link can have several origins
+enum class EdgeKind {
+    EXPLICIT = 0,  // explicit input of a ninja build statement
+    IMPLICIT,      // implicit input ( | ) of a ninja build statement
+    ORDER_ONLY,    // order-only input ( || ) of a ninja build statement
+    DEPS_LOG,      // header dependency recorded in .ninja_deps
+    CMAKE,         // source of a target in the cmake file api reply
+    Count
+};
+
+// Set of edge kinds, one bit per EdgeKind
+using EdgeKindMask = uint32_t;
+
+inline constexpr EdgeKindMask toMask(EdgeKind aKind) {
+    return 1U << static_cast<uint32_t>(aKind);
+}
+
+inline constexpr EdgeKindMask ALL_EDGE_KINDS{(1U << static_cast<uint32_t>(EdgeKind::Count)) - 1U};
+
+// order-only edges are scheduling barriers (generated headers, utility targets),
+// a change does not propagate through them
+inline constexpr EdgeKindMask DEFAULT_EDGE_KINDS{ALL_EDGE_KINDS & ~toMask(EdgeKind::ORDER_ONLY)};
+
+struct TraversalOptions {
+    EdgeKindMask edgeKinds{DEFAULT_EDGE_KINDS};  // a link is followed if one of its kinds is in the mask
+};
+
+struct SeedOptions {
+    PathMatch match{PathMatch::SUBSTRING};
+    std::filesystem::path sourceRoot;  // if set, SUFFIX matching is exact : sourceRoot/file
+    std::filesystem::path buildDir;    // base of the relative graph paths
+};
+
+// one query of a batch
+struct PointedQuery {
+    std::vector<std::string> files;
+    TargetTypeMask typeMask{};
+    TraversalOptions traversalOptions;
+    const utils::PathMatcher* pMatcher{nullptr};  // filter of the results, nullptr for all
+};
+
 }  // namespace datas
 }  // namespace kunai
@@ -1,63 +1,304 @@
 #include "loader.h"
 
+#include <tuple>
+#include <algorithm>
 #include <chrono>
+#include <thread>
 
 #include <ezlibs/ezTime.hpp>
 
 #include <app/headers/defs.hpp>
 #include <app/parsers/ninja/build_parser.h>
 #include <app/parsers/ninja/deps_parser.h>
+#include <app/parsers/ninja/log_parser.h>
 #include <app/parsers/cmake/reply_parser.h>
+#include <app/utils/cpu_timer.h>
+#include <app/utils/path_matcher.h>
 
 namespace fs = std::filesystem;
 
 namespace kunai {
 
-std::pair<std::unique_ptr<Loader>, std::string> Loader::create(const std::filesystem::path& buildDir, bool aRebuild) {
+std::pair<std::unique_ptr<Loader>, std::string> Loader::create(
+    const std::filesystem::path& buildDir,
+    bool aRebuild,
+    datas::Backend aBackend,
+    uint32_t aLockTimeoutMs,
+    datas::HashAlgo aHashAlgo) {
     auto pRet = std::make_unique<Loader>();
+    pRet->m_backend = aBackend;
+    pRet->m_lockTimeoutMs = aLockTimeoutMs;
+    pRet->m_hashAlgo = aHashAlgo;
     std::string error;
-    if (!pRet->m_load(buildDir, aRebuild)) {
+    // absolute, the files opened lazily must not depend on the current dir (changed by the serve daemon)
+    std::error_code ec;
+    const auto absBuildDir = fs::absolute(buildDir, ec).lexically_normal();
+    if (!pRet->m_load(ec ? buildDir : absBuildDir, aRebuild)) {
         error = pRet->getError();
         pRet.reset();
     }
     return std::make_pair(std::move(pRet), error);
 }
 
+void Loader::ParseJob::run(const std::function<void(ParseJob&)>& aParse) {
+    {
+        ez::time::ScopedTimer t(wallMs);
+        utils::ScopedCpuTimer c(cpuMs);
+        aParse(*this);
+    }
+    channel.close();
+}
+
 std::string Loader::getError() const {
     return m_error.str();
 }
 
-DataBase::Stats Loader::getStats() const {
-    return m_db.getStats();
+void Loader::m_clearError() {
+    m_error.str({});
+    m_error.clear();
 }
 
-std::vector<std::string> Loader::getAllTargetsByType(datas::TargetType aTargetType) {
-    std::vector<std::string> ret;
+double Loader::getLockWaitedMs() const {
+    return m_lockWaitedMs;
+}
+
+bool Loader::isFresh() {
+    return m_getFreshnessStamp(m_buildDir).isSameState(m_loadedStamp);
+}
+
+DataBase::Stats Loader::getStats() {
+    m_clearError();
+    DataBase::Stats ret;
+    if (m_openDb()) {
+        ret = m_db.getStats();
+    }
+    const auto measures = mp_telemetry->aggregate();
+    auto fill = [&measures](const char* aKey, DataBase::Stats::Measure& aoMeasure) {
+        const auto it = measures.find(aKey);
+        if (it != measures.end()) {
+            aoMeasure.last = it->second.last;
+            aoMeasure.mean = it->second.mean;
+            aoMeasure.count = it->second.count;
+        }
+    };
+    fill("perf_db_filling_ms", ret.timings.dbFilling);
+    fill("perf_db_loading_ms", ret.timings.dbLoading);
+    fill("perf_query_ms", ret.timings.query);
+    fill("perf_parse_build_ms", ret.phases.parseBuild.wall);
+    fill("perf_parse_build_cpu_ms", ret.phases.parseBuild.cpu);
+    fill("perf_parse_deps_ms", ret.phases.parseDeps.wall);
+    fill("perf_parse_deps_cpu_ms", ret.phases.parseDeps.cpu);
+    fill("perf_parse_cmake_ms", ret.phases.parseCMake.wall);
+    fill("perf_parse_cmake_cpu_ms", ret.phases.parseCMake.cpu);
+    fill("perf_parsing_ms", ret.phases.parsing.wall);
+    fill("perf_writing_ms", ret.phases.writing.wall);
+    fill("perf_writing_cpu_ms", ret.phases.writing.cpu);
+    fill("perf_queue_batches", ret.queue.batches);
+    fill("perf_queue_depth_max", ret.queue.maxDepth);
+    fill("perf_queue_depth_mean", ret.queue.meanDepth);
+    fill("perf_parser_stall_ms", ret.queue.parserStall);
+    fill("perf_writer_wait_ms", ret.queue.writerWait);
+    return ret;
+}
+
+datas::TargetsByType Loader::getAllTargets(datas::TargetTypeMask aTypeMask, const utils::PathMatcher* apMatcher) {
+    m_clearError();
+    datas::TargetsByType ret;
     double query_timing{};
     {
         ez::time::ScopedTimer t(query_timing);
-        ret = m_db.getAllTargetsByType(aTargetType);
+        if (mp_engine != nullptr) {
+            ret = mp_engine->getAllTargets(aTypeMask, apMatcher);
+        } else {
+            ret = m_db.getAllTargets(aTypeMask, apMatcher);
+        }
     }
     if (!ret.empty()) {
-        m_db.setMetadata("perf_query_ms", query_timing);
+        mp_telemetry->record("perf_query_ms", query_timing);
     }
     return ret;
 }
 
-std::vector<std::string> Loader::getPointedTargetsByType(const std::vector<std::string>& sourcePaths, datas::TargetType aTargetType) {
-    std::vector<std::string> ret;
+datas::TargetsByType Loader::getPointedTargets(
+    const std::vector<std::string>& sourcePaths,
+    datas::TargetTypeMask aTypeMask,
+    const datas::SeedOptions& aSeedOptions,
+    const datas::TraversalOptions& aTraversalOptions,
+    const utils::PathMatcher* apMatcher) {
+    m_clearError();
+    datas::TargetsByType ret;
     double query_timing{};
     {
         ez::time::ScopedTimer t(query_timing);
-        ret = m_db.getPointedTargetsByType(sourcePaths, aTargetType);
+        if (mp_engine != nullptr) {
+            ret = mp_engine->getPointedTargets(sourcePaths, aTypeMask, aSeedOptions, aTraversalOptions, apMatcher);
+        } else {
+            ret = m_db.getPointedTargets(sourcePaths, aTypeMask, aSeedOptions, aTraversalOptions, apMatcher);
+        }
     }
     if (!ret.empty()) {
-        m_db.setMetadata("perf_query_ms", query_timing);
+        mp_telemetry->record("perf_query_ms", query_timing);
+    }
+    return ret;
+}
+
+std::vector<datas::TargetsByType> Loader::getPointedTargetsBatch(const std::vector<datas::PointedQuery>& aQueries, const datas::SeedOptions& aSeedOptions) {
+    m_clearError();
+    if (mp_engine != nullptr) {
+        return mp_engine->getPointedTargetsBatch(aQueries, aSeedOptions);
+    }
+    // the sqlite backend maps the snapshot, like for the hotspots
+    if ((mp_snapshot != nullptr) || m_openSnapshot(m_buildDir)) {
+        const graph::Engine engine(*mp_snapshot);
+        return engine.getPointedTargetsBatch(aQueries, aSeedOptions);
+    }
+    std::vector<datas::TargetsByType> ret;
+    for (const auto& query : aQueries) {
+        ret.push_back(m_db.getPointedTargets(query.files, query.typeMask, aSeedOptions, query.traversalOptions, query.pMatcher));
+    }
+    return ret;
+}
+
+bool Loader::getPointedTargetsOrdered(
+    const std::vector<std::string>& sourcePaths,
+    datas::TargetTypeMask aTypeMask,
+    const datas::SeedOptions& aSeedOptions,
+    const datas::TraversalOptions& aTraversalOptions,
+    const utils::PathMatcher* apMatcher,
+    datas::TargetOrder aOrder,
+    const std::function<void(const std::vector<std::string_view>& aTargets)>& aOnTargets) {
+    m_clearError();
+    if ((mp_snapshot == nullptr) && !m_openSnapshot(m_buildDir)) {
+        return false;
+    }
+    // the sqlite backend walks the snapshot, like for the batch
+    std::unique_ptr<graph::Engine> tmp_pEngine;
+    if (mp_engine == nullptr) {
+        tmp_pEngine = std::make_unique<graph::Engine>(*mp_snapshot);
+    }
+    const auto& engine = (mp_engine != nullptr) ? *mp_engine : *tmp_pEngine;
+
+    if (aOrder == datas::TargetOrder::DISTANCE) {
+        std::vector<std::string_view> targets;
+        auto onLevel = [this, &targets, &aOnTargets](uint32_t, const std::vector<uint32_t>& aNodeIds) {
+            targets.clear();
+            for (const auto id : aNodeIds) {
+                targets.push_back(mp_snapshot->getPath(id));
+            }
+            std::sort(targets.begin(), targets.end());
+            aOnTargets(targets);
+        };
+        engine.forEachPointedLevel(sourcePaths, aTypeMask, aSeedOptions, aTraversalOptions, apMatcher, onLevel);
+        return true;
+    }
+
+    // cost : all the levels are needed before the first target
+    struct Reached {
+        uint32_t nodeId{};
+        uint32_t depth{};
+        double cost{};
+    };
+    std::vector<Reached> reached;
+    const auto costs = m_getNodesCosts();  // empty without .ninja_log, the order is then the distance one
+    auto onLevel = [&reached, &costs](uint32_t aDepth, const std::vector<uint32_t>& aNodeIds) {
+        for (const auto id : aNodeIds) {
+            reached.push_back({id, aDepth, costs.empty() ? 0.0 : costs[id]});
+        }
+    };
+    engine.forEachPointedLevel(sourcePaths, aTypeMask, aSeedOptions, aTraversalOptions, apMatcher, onLevel);
+    std::sort(reached.begin(), reached.end(), [this](const Reached& a, const Reached& b) {
+        if (a.cost != b.cost) {
+            return a.cost < b.cost;
+        }
+        if (a.depth != b.depth) {
+            return a.depth < b.depth;
+        }
+        return mp_snapshot->getPath(a.nodeId) < mp_snapshot->getPath(b.nodeId);
+    });
+    std::vector<std::string_view> targets;
+    for (const auto& entry : reached) {
+        targets.push_back(mp_snapshot->getPath(entry.nodeId));
+    }
+    aOnTargets(targets);
+    return true;
+}
+
+std::vector<graph::Hotspots::Entry> Loader::getHotspots(datas::TargetTypeMask aTypeMask, datas::EdgeKindMask aEdgeKinds, bool& aoHasCosts) {
+    m_clearError();
+    aoHasCosts = false;
+    if ((mp_snapshot == nullptr) && !m_openSnapshot(m_buildDir)) {
+        return {};
+    }
+    const auto costs = m_getNodesCosts();
+    aoHasCosts = !costs.empty();
+    return graph::Hotspots::compute(*mp_snapshot, aTypeMask, costs, aEdgeKinds);
+}
+
+std::vector<std::string> Loader::getRebuildSet(const std::vector<std::string>& aOutputs) {
+    m_clearError();
+    std::vector<std::string> ret;
+    if ((mp_snapshot == nullptr) && !m_openSnapshot(m_buildDir)) {
+        return ret;
+    }
+    std::vector<uint32_t> selected;
+    for (const auto& output : aOutputs) {
+        for (const auto id : mp_snapshot->findBySuffix(output)) {
+            if (mp_snapshot->getPath(id) == output) {
+                selected.push_back(id);
+            }
+        }
+    }
+    for (const auto id : graph::RebuildSet::compute(*mp_snapshot, selected)) {
+        ret.emplace_back(mp_snapshot->getPath(id));
+    }
+    return ret;
+}
+
+std::vector<graph::Fingerprint::Entry> Loader::getFingerprints(datas::EdgeKindMask aEdgeKinds, const utils::PathMatcher* apMatcher) {
+    m_clearError();
+    if ((mp_snapshot == nullptr) && !m_openSnapshot(m_buildDir)) {
+        return {};
+    }
+    std::vector<uint32_t> targets;
+    for (uint32_t id = 0U; id < mp_snapshot->getNodesCount(); ++id) {
+        if ((mp_snapshot->getType(id) == datas::TargetType::BINARY) &&  //
+            ((apMatcher == nullptr) || apMatcher->isMatching(mp_snapshot->getPath(id)))) {
+            targets.push_back(id);
+        }
+    }
+    const auto cachePath = m_buildDir / datas::KUNAI_HASHES_NAME;
+    if (mp_hashCache == nullptr) {
+        mp_hashCache = std::make_unique<utils::HashCache>(m_hashAlgo);
+        mp_hashCache->load(cachePath);  // missing at the first run
+    }
+    auto ret = graph::Fingerprint::compute(*mp_snapshot, m_buildDir, targets, aEdgeKinds, *mp_hashCache);
+    mp_hashCache->save(cachePath);  // not fatal if it fails, the files will be hashed again by the next run
+    return ret;
+}
+
+std::vector<double> Loader::m_getNodesCosts() {
+    std::vector<double> ret;
+    const auto logPath = m_buildDir / ".ninja_log";
+    if (!fs::exists(logPath)) {
+        return ret;
+    }
+    auto tmp_pLogParser = ninja::LogParser::create(logPath.string());
+    if (tmp_pLogParser.first == nullptr) {
+        return ret;  // not fatal, the costs are just not reported
+    }
+    const auto& durations = tmp_pLogParser.first->getDurations();
+    const auto nodesCount = mp_snapshot->getNodesCount();
+    ret.resize(nodesCount, 0.0);
+    for (uint32_t id = 0U; id < nodesCount; ++id) {
+        const auto it = durations.find(std::string(mp_snapshot->getPath(id)));
+        if (it != durations.end()) {
+            ret[id] = it->second;
+        }
     }
     return ret;
 }
 
-// Check if database needs rebuild based on SHA1 changes
+// Check if database needs rebuild based on content hash changes
 void Loader::m_checkStatus(const fs::path& buildDir, bool aForceRebuild, Loader::Status& aoStatus) {
     // Get file paths
     fs::path buildNinjaPath = buildDir / "build.ninja";
@@ -67,9 +308,11 @@ void Loader::m_checkStatus(const fs::path& buildDir, bool aForceRebuild, Loader:
     std::error_code ec;
     if (fs::exists(buildNinjaPath, ec)) {
         aoStatus.buildNinjaTime = fs::last_write_time(buildNinjaPath, ec);
+        aoStatus.buildNinjaSize = fs::file_size(buildNinjaPath, ec);
     }
     if (fs::exists(ninjaDepsPath, ec)) {
         aoStatus.ninjaDepsTime = fs::last_write_time(ninjaDepsPath, ec);
+        aoStatus.ninjaDepsSize = fs::file_size(ninjaDepsPath, ec);
     }
 
     // Get stored timestamps (stored as nanoseconds since epoch)
@@ -84,137 +327,442 @@ void Loader::m_checkStatus(const fs::path& buildDir, bool aForceRebuild, Loader:
     bool buildTimeChanged = (storedBuildTime.empty() || storedBuildTime != std::to_string(buildTimeNanos));
     bool depsTimeChanged = (storedDepsTime.empty() || storedDepsTime != std::to_string(depsTimeNanos));
 
-    // Only compute SHA1 if timestamps have changed
-    if (buildTimeChanged || aForceRebuild) {
-        aoStatus.buildNinjaSha1 = m_computeSha1(buildNinjaPath);
-        std::string storedBuildSha1 = m_db.getMetadata("build_ninja_sha1");
-        aoStatus.buildNinjaChanged = (aoStatus.buildNinjaSha1 != storedBuildSha1);
-    } else {
-        aoStatus.buildNinjaChanged = false;
-    }
-
-    if (depsTimeChanged || aForceRebuild) {
-        aoStatus.ninjaDepsSha1 = m_computeSha1(ninjaDepsPath);
-        std::string storedDepsSha1 = m_db.getMetadata("ninja_deps_sha1");
-        aoStatus.ninjaDepsChanged = (aoStatus.ninjaDepsSha1 != storedDepsSha1);
-    } else {
-        aoStatus.ninjaDepsChanged = false;
+    // a database of another layout can't be queried, it's rebuilt as if forced
+    aForceRebuild = aForceRebuild || (m_db.getSchemaVersion() != datas::KUNAI_SCHEMA_VERSION);
+
+    // A size change is a content change. the rebuild hashes the files while parsing them,
+    // so a file is only hashed here when its timestamp changed but not its size
+    const auto storedBuildSize = m_db.getMetadata("build_ninja_size");
+    const auto storedDepsSize = m_db.getMetadata("ninja_deps_size");
+    const bool buildSizeChanged = buildTimeChanged && !storedBuildSize.empty() && (storedBuildSize != std::to_string(aoStatus.buildNinjaSize));
+    const bool depsSizeChanged = depsTimeChanged && !storedDepsSize.empty() && (storedDepsSize != std::to_string(aoStatus.ninjaDepsSize));
+    const bool rebuildKnown = aForceRebuild || buildSizeChanged || depsSizeChanged;
+    const bool buildNeedsHash = !rebuildKnown && buildTimeChanged;
+    const bool depsNeedsHash = !rebuildKnown && depsTimeChanged;
+
+    // hashed with the algorithm of the stored hashes
+    std::string storedBuildHash;
+    std::string storedDepsHash;
+    const auto storedAlgo = m_getStoredHashes(storedBuildHash, storedDepsHash);
+    std::string buildHash;
+    std::string depsHash;
+    if (buildNeedsHash && depsNeedsHash) {
+        std::tie(buildHash, depsHash) = utils::FileHash::computePair(buildNinjaPath, ninjaDepsPath, storedAlgo);
+    } else if (buildNeedsHash) {
+        buildHash = utils::FileHash::compute(buildNinjaPath, storedAlgo);
+    } else if (depsNeedsHash) {
+        depsHash = utils::FileHash::compute(ninjaDepsPath, storedAlgo);
     }
+    aoStatus.buildNinjaChanged = buildSizeChanged || (buildNeedsHash && (buildHash != storedBuildHash));
+    aoStatus.ninjaDepsChanged = depsSizeChanged || (depsNeedsHash && (depsHash != storedDepsHash));
 
     aoStatus.needsRebuild = aForceRebuild || (aoStatus.buildNinjaChanged || aoStatus.ninjaDepsChanged);
 }
 
-std::string Loader::m_computeSha1(const fs::path& filepath) {
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file.is_open()) {
-        return {};
+datas::HashAlgo Loader::m_getStoredHashes(std::string& aoBuildNinjaHash, std::string& aoNinjaDepsHash) {
+    datas::HashAlgo ret{m_hashAlgo};
+    const auto algoName = m_db.getMetadata("hash_algo");
+    if (!algoName.empty()) {
+        if (utils::FileHash::parseName(algoName, ret)) {
+            aoBuildNinjaHash = m_db.getMetadata("build_ninja_hash");
+            aoNinjaDepsHash = m_db.getMetadata("ninja_deps_hash");
+        }
+    } else if (!m_db.getMetadata("build_ninja_sha1").empty()) {
+        ret = datas::HashAlgo::SHA1;
+        aoBuildNinjaHash = m_db.getMetadata("build_ninja_sha1");
+        aoNinjaDepsHash = m_db.getMetadata("ninja_deps_sha1");
     }
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    std::string content = ss.str();
-    ez::sha1 sha;
-    sha.add(content);
-    sha.finalize();
-    return sha.getHex();
+    return ret;
 }
 
 // Load ninja files into database
 bool Loader::m_load(const fs::path& buildDir, bool aForceRebuild) {
     if (!fs::exists(buildDir)) {
+        m_error << "Build dir not found";
+        return false;
+    }
+    m_buildDir = buildDir;
+    mp_telemetry = std::make_unique<utils::Telemetry>(buildDir / datas::KUNAI_TELEMETRY_NAME, buildDir / datas::KUNAI_TELEMETRY_LOCK_NAME);
+
+    // fast path : build files unchanged since the last check, the database is not even opened
+    const auto stampPath = buildDir / datas::KUNAI_STAMP_NAME;
+    utils::FreshnessStamp currentStamp = m_getFreshnessStamp(buildDir);
+    utils::FreshnessStamp storedStamp;
+    if (!aForceRebuild && storedStamp.load(stampPath) && storedStamp.isSameState(currentStamp) && fs::exists(buildDir / datas::KUNAI_DB_NAME)) {
+        m_graphStamp = storedStamp.graphStamp;
+    } else {
+        if (!m_update(buildDir, aForceRebuild)) {
+            return false;
+        }
+        currentStamp.graphStamp = m_graphStamp;
+        currentStamp.save(stampPath);  // not fatal, the next run will check again
+    }
+    m_loadedStamp = currentStamp;
+
+    // the sqlite backend queries the database, the others only need it for the stats
+    if ((m_backend == datas::Backend::SQLITE) && !m_openDb()) {
         return false;
     }
 
+    if (m_backend == datas::Backend::SNAPSHOT) {
+        if (!m_openSnapshot(buildDir)) {
+            return false;
+        }
+        mp_engine = std::make_unique<graph::Engine>(*mp_snapshot);
+    }
+
+    if (m_backend == datas::Backend::CLOSURE) {
+        if (!m_openSnapshot(buildDir) || !m_openClosure(buildDir)) {
+            return false;
+        }
+        mp_engine = std::make_unique<graph::Engine>(*mp_snapshot, mp_closure.get());
+    }
+
+    return true;
+}
+
+utils::FreshnessStamp Loader::m_getFreshnessStamp(const fs::path& buildDir) {
+    utils::FreshnessStamp ret;
+    ret.schemaVersion = datas::KUNAI_SCHEMA_VERSION;
+    ret.buildNinja = utils::FileStamp::get(buildDir / "build.ninja");
+    ret.ninjaDeps = utils::FileStamp::get(buildDir / ".ninja_deps");
+    return ret;
+}
+
+bool Loader::m_openDb() {
+    if (m_db.isOpened()) {
+        return true;
+    }
     double db_loading_timing{};
     {
         ez::time::ScopedTimer t(db_loading_timing);
-
-        if (!m_db.open(buildDir / datas::KUNAI_DB_NAME)) {
+        if (!m_db.openReadOnly(m_buildDir / datas::KUNAI_DB_NAME)) {
             m_error << "Error: " << m_db.getError() << "\n";
             return false;
         }
     }
-    m_db.setMetadata("perf_db_loading_ms", db_loading_timing);
+    mp_telemetry->record("perf_db_loading_ms", db_loading_timing);
+    return true;
+}
 
-    fs::path buildNinjaPath = buildDir / "build.ninja";
-    fs::path ninjaDepsPath = buildDir / ".ninja_deps";
+bool Loader::m_update(const fs::path& buildDir, bool aForceRebuild) {
+    // the queries never write the database. a missing database is built by the rebuild
+    const auto dbPath = buildDir / datas::KUNAI_DB_NAME;
+    if (fs::exists(dbPath) && !m_openDb()) {
+        return false;
+    }
 
     // Check if rebuild needed
     Status status;
 
     m_checkStatus(buildDir, aForceRebuild, status);
 
+    // single flight : one process rebuilds, the others wait for it then use its database.
+    // the lock is held until the snapshot is written
+    std::unique_ptr<utils::FileLock> pLock;
     if (status.needsRebuild) {
-        if (!status.buildNinjaSha1.empty()) {
-            m_db.setMetadata("build_ninja_time", status.buildNinjaTime.time_since_epoch().count());
+        auto tmp_pLock = utils::FileLock::create(buildDir / datas::KUNAI_LOCK_NAME, m_lockTimeoutMs);
+        if (tmp_pLock.first == nullptr) {
+            m_error << "Failed to wait for the rebuild : " << tmp_pLock.second;
+            return false;
         }
-        if (!status.ninjaDepsSha1.empty()) {
-            m_db.setMetadata("ninja_deps_time", status.ninjaDepsTime.time_since_epoch().count());
+        pLock = std::move(tmp_pLock.first);
+        if (pLock->hasWaited()) {
+            m_lockWaitedMs = pLock->getWaitedMs();
+            mp_telemetry->record("perf_lock_wait_ms", m_lockWaitedMs);
         }
-    } else {
-        return true;  // Nothing to do
+        // another process may have rebuilt between the check and the lock, even without a wait.
+        // a forced rebuild is considered done by the holder we waited for
+        if (fs::exists(dbPath) && !m_db.openReadOnly(dbPath)) {
+            m_error << "Error: " << m_db.getError() << "\n";
+            return false;
+        }
+        status = Status{};
+        m_checkStatus(buildDir, aForceRebuild && !pLock->hasWaited(), status);
     }
 
-    double db_filling_timing{};
-    {
-        ez::time::ScopedTimer t(db_filling_timing);
+    if (status.needsRebuild) {
+        double db_filling_timing{};
+        {
+            ez::time::ScopedTimer t(db_filling_timing);
+            if (!m_rebuild(buildDir, status)) {
+                return false;
+            }
+        }
+        mp_telemetry->record("perf_db_filling_ms", db_filling_timing);
 
-        // Begin transaction
-        if (!m_db.beginTransaction()) {
-            m_error << "Failed to begin transaction: " << m_db.getError();
+        // the snapshot is always emitted, whatever the backend in use
+        m_graphStamp = m_getGraphStamp();
+        if (!m_writeSnapshot(buildDir)) {
             return false;
         }
+    }
 
-        // Clear and reload
-        m_db.clear();
+    m_graphStamp = m_getGraphStamp();
+    return true;
+}
 
-        // Initialize default file extensions
-        m_db.initializeDefaultExtensions();
+// Build a fresh shadow database then swap it in place of the current one.
+// readers of the current database are never blocked and never see a partial graph
+bool Loader::m_rebuild(const fs::path& buildDir, const Status& aStatus) {
+    const fs::path dbPath = buildDir / datas::KUNAI_DB_NAME;
+    const fs::path tmpDbPath = buildDir / datas::KUNAI_DB_TMP_NAME;
+    const fs::path buildNinjaPath = buildDir / "build.ninja";
+    const fs::path ninjaDepsPath = buildDir / ".ninja_deps";
 
-        // Parse build.ninja - data is inserted directly to DB during parsing
-        if (fs::exists(buildNinjaPath)) {
-            auto tmp_pBuildParser = ninja::BuildParser::create(buildNinjaPath.string(), m_db);
-            if (tmp_pBuildParser.first == nullptr) {
-                m_db.rollback();
-                m_error << "Failed to parse build.ninja: " << tmp_pBuildParser.second;
-                return false;
-            }
-        } else {
-            m_db.rollback();
-            m_error << "build.ninja is not existing";
-            return false;
-        }
+    std::error_code ec;
+    fs::remove(tmpDbPath, ec);  // leftover of an aborted rebuild
 
-        // Parse .ninja_deps (optional) - data is inserted directly to DB during parsing
-        if (fs::exists(ninjaDepsPath)) {
-            auto tmp_pDepsParser = ninja::DepsParser::create(ninjaDepsPath.string(), m_db);
-            if (tmp_pDepsParser.first == nullptr) {
-                m_db.rollback();
-                m_error << "Failed to parse .ninja_deps: " << tmp_pDepsParser.second;
-                return false;
+    DataBase shadowDb;
+    auto discard = [&shadowDb, &tmpDbPath]() {
+        shadowDb.close();
+        std::error_code ec;
+        fs::remove(tmpDbPath, ec);
+        return false;
+    };
+
+    if (!shadowDb.openForBulkLoad(tmpDbPath)) {
+        m_error << "Error: " << shadowDb.getError() << "\n";
+        return discard();
+    }
+
+    // Begin transaction
+    if (!shadowDb.beginTransaction()) {
+        m_error << "Failed to begin transaction: " << shadowDb.getError();
+        return discard();
+    }
+
+    // Initialize default file extensions
+    shadowDb.initializeDefaultExtensions();
+
+    if (!fs::exists(buildNinjaPath)) {
+        m_error << "build.ninja is not existing";
+        return discard();
+    }
+
+    // The three inputs are independent until merged : each one is parsed on its own thread
+    // and streams batches of records to the writer thread, the single writer of the database.
+    // the writer drains the parsers in the order of the sequential load, the node ids don't
+    // depend on the threads. the files are hashed from the bytes parsed, the hashes always match the graph
+    ParseJob buildJob;
+    ParseJob depsJob;
+    ParseJob cmakeJob;
+    double parsingTiming{};
+    double writingTiming{};
+    double writingCpuTiming{};
+    {
+        std::thread writerThread([&shadowDb, &buildJob, &depsJob, &cmakeJob, &writingTiming, &writingCpuTiming]() {
+            ez::time::ScopedTimer t(writingTiming);
+            utils::ScopedCpuTimer c(writingCpuTiming);
+            for (auto* pJob : {&buildJob, &depsJob, &cmakeJob}) {
+                std::unique_ptr<Staging> pBatch;
+                while (pJob->channel.pop(pBatch)) {
+                    pBatch->mergeInto(shadowDb);
+                    pJob->channel.recycle(std::move(pBatch));
+                }
             }
+        });
+        {
+            ez::time::ScopedTimer t(parsingTiming);
+            std::thread buildThread(&ParseJob::run, &buildJob, [this, &buildNinjaPath](ParseJob& arJob) {
+                auto tmp_pBuildParser = ninja::BuildParser::create(buildNinjaPath.string(), arJob.channel, m_hashAlgo);
+                if (tmp_pBuildParser.first == nullptr) {
+                    arJob.error = "Failed to parse build.ninja: " + tmp_pBuildParser.second;
+                    return;
+                }
+                arJob.contentHash = tmp_pBuildParser.first->getContentHash();
+            });
+            // .ninja_deps is optional
+            std::thread depsThread(&ParseJob::run, &depsJob, [this, &ninjaDepsPath](ParseJob& arJob) {
+                if (!fs::exists(ninjaDepsPath)) {
+                    return;
+                }
+                auto tmp_pDepsParser = ninja::DepsParser::create(ninjaDepsPath.string(), arJob.channel, m_hashAlgo);
+                if (tmp_pDepsParser.first == nullptr) {
+                    arJob.error = "Failed to parse .ninja_deps: " + tmp_pDepsParser.second;
+                    return;
+                }
+                arJob.contentHash = tmp_pDepsParser.first->getContentHash();
+            });
+            // CMake reply parsing failures are not fatal - it's an optional enhancement
+            cmakeJob.run([&buildDir](ParseJob& arJob) {  //
+                cmake::ReplyParser::create(buildDir.string(), arJob.channel);
+            });
+            buildThread.join();
+            depsThread.join();
+        }
+        writerThread.join();
+    }
+    for (const auto* pJob : {&buildJob, &depsJob}) {
+        if (!pJob->error.empty()) {
+            m_error << pJob->error;
+            return discard();
         }
+    }
+
+    StagingChannel::Stats queueStats;
+    double depthsSum{};
+    for (const auto* pJob : {&buildJob, &depsJob, &cmakeJob}) {
+        const auto stats = pJob->channel.getStats();
+        queueStats.batchesCount += stats.batchesCount;
+        queueStats.maxDepth = std::max(queueStats.maxDepth, stats.maxDepth);
+        queueStats.producerStallMs += stats.producerStallMs;
+        queueStats.consumerWaitMs += stats.consumerWaitMs;
+        depthsSum += stats.meanDepth * static_cast<double>(stats.batchesCount);
+    }
+    if (queueStats.batchesCount > 0U) {
+        queueStats.meanDepth = depthsSum / static_cast<double>(queueStats.batchesCount);
+    }
+    mp_telemetry->record("perf_parse_build_ms", buildJob.wallMs);
+    mp_telemetry->record("perf_parse_build_cpu_ms", buildJob.cpuMs);
+    mp_telemetry->record("perf_parse_deps_ms", depsJob.wallMs);
+    mp_telemetry->record("perf_parse_deps_cpu_ms", depsJob.cpuMs);
+    mp_telemetry->record("perf_parse_cmake_ms", cmakeJob.wallMs);
+    mp_telemetry->record("perf_parse_cmake_cpu_ms", cmakeJob.cpuMs);
+    mp_telemetry->record("perf_parsing_ms", parsingTiming);
+    mp_telemetry->record("perf_writing_ms", writingTiming);
+    mp_telemetry->record("perf_writing_cpu_ms", writingCpuTiming);
+    mp_telemetry->record("perf_queue_batches", static_cast<double>(queueStats.batchesCount));
+    mp_telemetry->record("perf_queue_depth_max", static_cast<double>(queueStats.maxDepth));
+    mp_telemetry->record("perf_queue_depth_mean", queueStats.meanDepth);
+    mp_telemetry->record("perf_parser_stall_ms", queueStats.producerStallMs);
+    mp_telemetry->record("perf_writer_wait_ms", queueStats.consumerWaitMs);
+    const auto& buildNinjaHash = buildJob.contentHash;
+    const auto& ninjaDepsHash = depsJob.contentHash;
+
+    // Store hashes, sizes and timestamps, in the transaction of the graph
+    shadowDb.setMetadata("hash_algo", utils::FileHash::getName(m_hashAlgo));
+    shadowDb.setMetadata("build_ninja_hash", buildNinjaHash);
+    shadowDb.setMetadata("ninja_deps_hash", ninjaDepsHash);
+    shadowDb.setMetadata("build_ninja_size", aStatus.buildNinjaSize);
+    shadowDb.setMetadata("ninja_deps_size", aStatus.ninjaDepsSize);
+    shadowDb.setMetadata("build_ninja_time", aStatus.buildNinjaTime.time_since_epoch().count());
+    shadowDb.setMetadata("ninja_deps_time", aStatus.ninjaDepsTime.time_since_epoch().count());
+    shadowDb.setMetadata("build_dir", buildDir.string());
+    if (!shadowDb.setSchemaVersion(datas::KUNAI_SCHEMA_VERSION)) {
+        m_error << "Failed to set the schema version: " << shadowDb.getError();
+        return discard();
+    }
+
+    // counted once here, stats doesn't scan the tables
+    if (!shadowDb.storeCounters()) {
+        m_error << "Failed to count the targets: " << shadowDb.getError();
+        return discard();
+    }
+
+    // Indexes are built once over the loaded datas, not maintained row by row
+    if (!shadowDb.createIndexes()) {
+        m_error << "Failed to create indexes: " << shadowDb.getError();
+        return discard();
+    }
+
+    // Commit
+    if (!shadowDb.commit()) {
+        m_error << "Failed to commit: " << shadowDb.getError();
+        return discard();
+    }
+    shadowDb.close();
+
+    // Atomic swap. the current db must be closed first for win32
+    m_db.close();
+    fs::rename(tmpDbPath, dbPath, ec);
+    if (ec) {
+        m_error << "Failed to replace " << dbPath.string() << " : " << ec.message();
+        discard();
+        m_db.openReadOnly(dbPath);
+        return false;
+    }
+
+    if (!m_db.openReadOnly(dbPath)) {
+        m_error << "Error: " << m_db.getError() << "\n";
+        return false;
+    }
+
+    return true;
+}
 
-        // Parse CMake reply files (optional) - data is inserted directly to DB during parsing
-        auto tmp_pCMakeParser = cmake::ReplyParser::create(buildDir.string(), m_db);
-        // Note: CMake reply parsing failures are not fatal - it's an optional enhancement
+std::string Loader::m_getGraphStamp() {
+    std::string buildNinjaHash;
+    std::string ninjaDepsHash;
+    m_getStoredHashes(buildNinjaHash, ninjaDepsHash);
+    return buildNinjaHash + ":" + ninjaDepsHash;
+}
 
-        // Store SHA1s and timestamps
-        m_db.setMetadata("build_ninja_sha1", status.buildNinjaSha1);
-        m_db.setMetadata("ninja_deps_sha1", status.ninjaDepsSha1);
-        m_db.setMetadata("build_ninja_time", status.buildNinjaTime.time_since_epoch().count());
-        m_db.setMetadata("ninja_deps_time", status.ninjaDepsTime.time_since_epoch().count());
-        m_db.setMetadata("build_dir", buildDir.string());
+bool Loader::m_writeSnapshot(const fs::path& buildDir) {
+    std::string error;
+    if (!m_openDb()) {
+        return false;
+    }
+    if (!graph::Snapshot::write(m_db, m_graphStamp, buildDir / datas::KUNAI_SNAPSHOT_NAME, error)) {
+        m_error << "Failed to write the graph snapshot: " << error;
+        return false;
+    }
+    return true;
+}
 
-        // Commit
-        if (!m_db.commit()) {
-            m_db.rollback();
-            m_error << "Failed to commit: " << m_db.getError();
+bool Loader::m_openSnapshot(const fs::path& buildDir) {
+    const auto snapshotPath = buildDir / datas::KUNAI_SNAPSHOT_NAME;
+    auto isFresh = [this](const std::pair<std::unique_ptr<graph::Snapshot>, std::string>& aSnapshot) {
+        return (aSnapshot.first != nullptr) && (aSnapshot.first->getStamp() == m_graphStamp);
+    };
+    auto tmp_pSnapshot = graph::Snapshot::create(snapshotPath);
+    if (!isFresh(tmp_pSnapshot)) {
+        // missing, outdated, or made from another database state.
+        // single flight, like the rebuild : the others wait for the writer then map its file
+        tmp_pSnapshot.first.reset();
+        auto tmp_pLock = utils::FileLock::create(buildDir / datas::KUNAI_LOCK_NAME, m_lockTimeoutMs);
+        if (tmp_pLock.first == nullptr) {
+            m_error << "Failed to wait for the snapshot writing : " << tmp_pLock.second;
             return false;
         }
+        tmp_pSnapshot = graph::Snapshot::create(snapshotPath);
+        if (!isFresh(tmp_pSnapshot)) {
+            tmp_pSnapshot.first.reset();
+            if (!m_openDb()) {
+                return false;
+            }
+            std::string error;
+            graph::Snapshot::write(m_db, m_graphStamp, snapshotPath, error);
+            // a failed rename can be lost to a writer not holding the lock, its file is as good
+            tmp_pSnapshot = graph::Snapshot::create(snapshotPath);
+            if (!isFresh(tmp_pSnapshot)) {
+                m_error << "Failed to write the graph snapshot: " << (error.empty() ? tmp_pSnapshot.second : error);
+                return false;
+            }
+        }
     }
+    mp_snapshot = std::move(tmp_pSnapshot.first);
+    return true;
+}
 
-    m_db.setMetadata("perf_db_filling_ms", db_filling_timing);
-
+bool Loader::m_openClosure(const fs::path& buildDir) {
+    const auto closurePath = buildDir / datas::KUNAI_CLOSURE_NAME;
+    auto isFresh = [this](const std::pair<std::unique_ptr<graph::Closure>, std::string>& aClosure) {
+        return (aClosure.first != nullptr) && (aClosure.first->getStamp() == mp_snapshot->getStamp());
+    };
+    auto tmp_pClosure = graph::Closure::create(closurePath);
+    if (!isFresh(tmp_pClosure)) {
+        // computed once for all the processes, like the snapshot
+        tmp_pClosure.first.reset();
+        auto tmp_pLock = utils::FileLock::create(buildDir / datas::KUNAI_LOCK_NAME, m_lockTimeoutMs);
+        if (tmp_pLock.first == nullptr) {
+            m_error << "Failed to wait for the closure index writing : " << tmp_pLock.second;
+            return false;
+        }
+        tmp_pClosure = graph::Closure::create(closurePath);
+        if (!isFresh(tmp_pClosure)) {
+            tmp_pClosure.first.reset();
+            std::string error;
+            graph::Closure::write(*mp_snapshot, closurePath, error);
+            // a failed rename can be lost to a writer not holding the lock, its file is as good
+            tmp_pClosure = graph::Closure::create(closurePath);
+            if (!isFresh(tmp_pClosure)) {
+                m_error << "Failed to write the closure index: " << (error.empty() ? tmp_pClosure.second : error);
+                return false;
+            }
+        }
+    }
+    mp_closure = std::move(tmp_pClosure.first);
     return true;
 }
 
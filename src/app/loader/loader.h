@@ -5,16 +5,26 @@
  * 
  * Handles:
  *   - Parsing build.ninja and .ninja_deps
- *   - SHA1 checksums to detect changes
+ *   - content hashes (fast128 or sha1, see FileHash) to detect changes
  *   - Deciding whether to rebuild the database
  */
 
 #include <app/model/model.h>
-
-#include <ezlibs/ezSha.hpp>
+#include <app/model/staging.h>
+#include <app/graph/engine.h>
+#include <app/graph/snapshot.h>
+#include <app/graph/hotspots.h>
+#include <app/graph/rebuild_set.h>
+#include <app/graph/fingerprint.h>
+#include <app/utils/telemetry.h>
+#include <app/utils/file_lock.h>
+#include <app/utils/file_stamp.h>
+#include <app/utils/file_hash.h>
+#include <app/utils/hash_cache.h>
 
 #include <fstream>
 #include <sstream>
+#include <functional>
 #include <filesystem>
 
 namespace kunai {
@@ -25,18 +35,43 @@ public:
         bool needsRebuild = false;
         bool buildNinjaChanged = false;
         bool ninjaDepsChanged = false;
-        std::string buildNinjaSha1;
-        std::string ninjaDepsSha1;
+        uintmax_t buildNinjaSize{};
+        uintmax_t ninjaDepsSize{};
         std::filesystem::file_time_type buildNinjaTime;
         std::filesystem::file_time_type ninjaDepsTime;
     };
 
     static std::pair<std::unique_ptr<Loader>, std::string> create(  //
         const std::filesystem::path& buildDir,
-        bool aRebuild = false);
+        bool aRebuild = false,
+        datas::Backend aBackend = datas::Backend::SQLITE,
+        uint32_t aLockTimeoutMs = 600000U,
+        datas::HashAlgo aHashAlgo = datas::HashAlgo::FAST128);
 
 private:
+    // a parser of the rebuild, run on its own thread and streaming its records to the writer thread
+    struct ParseJob {
+        StagingChannel channel{8U, 4096U};  // batches in flight, records by batch
+        std::string contentHash;
+        std::string error;
+        double wallMs{};
+        double cpuMs{};
+        void run(const std::function<void(ParseJob&)>& aParse);
+    };
+
     DataBase m_db;
+    std::filesystem::path m_buildDir;
+    datas::Backend m_backend{datas::Backend::SQLITE};
+    uint32_t m_lockTimeoutMs{};
+    datas::HashAlgo m_hashAlgo{datas::HashAlgo::FAST128};  // used by the next rebuild
+    double m_lockWaitedMs{};
+    std::string m_graphStamp;  // content stamp of the database, see m_getGraphStamp
+    utils::FreshnessStamp m_loadedStamp;  // stat stamps of the build files when loaded
+    std::unique_ptr<graph::Snapshot> mp_snapshot;
+    std::unique_ptr<graph::Closure> mp_closure;
+    std::unique_ptr<graph::Engine> mp_engine;
+    std::unique_ptr<utils::Telemetry> mp_telemetry;
+    std::unique_ptr<utils::HashCache> mp_hashCache;  // loaded at the first fingerprint, kept by the serve daemon
     std::stringstream m_error;
 
 public:
@@ -47,20 +82,87 @@ public:
     // get the last error
     std::string getError() const;
 
+    // time spent waiting for the rebuild of another process
+    double getLockWaitedMs() const;
+
+    // true while the build files have the stat stamps the graph was loaded with
+    bool isFresh();
+
     // database getters
-    DataBase::Stats getStats() const;
-    std::vector<std::string> getAllTargetsByType(datas::TargetType aTargetType) ;
-    std::vector<std::string> getPointedTargetsByType(const std::vector<std::string>& sourcePaths, datas::TargetType aTargetType) ;
+    DataBase::Stats getStats();
+    // apMatcher filters the paths in the backend, nullptr for all
+    datas::TargetsByType getAllTargets(datas::TargetTypeMask aTypeMask, const utils::PathMatcher* apMatcher = nullptr);
+    datas::TargetsByType getPointedTargets(
+        const std::vector<std::string>& sourcePaths,
+        datas::TargetTypeMask aTypeMask,
+        const datas::SeedOptions& aSeedOptions = {},
+        const datas::TraversalOptions& aTraversalOptions = {},
+        const utils::PathMatcher* apMatcher = nullptr);
+    // one result by query, answered on the snapshot whatever the backend
+    std::vector<datas::TargetsByType> getPointedTargetsBatch(const std::vector<datas::PointedQuery>& aQueries, const datas::SeedOptions& aSeedOptions = {});
+
+    // pointed targets in aOrder (DISTANCE or COST), computed on the snapshot.
+    // aOnTargets gets the targets of each depth as soon as they are reached for DISTANCE, all of them at once for COST.
+    // false if the snapshot is not available
+    bool getPointedTargetsOrdered(
+        const std::vector<std::string>& sourcePaths,
+        datas::TargetTypeMask aTypeMask,
+        const datas::SeedOptions& aSeedOptions,
+        const datas::TraversalOptions& aTraversalOptions,
+        const utils::PathMatcher* apMatcher,
+        datas::TargetOrder aOrder,
+        const std::function<void(const std::vector<std::string_view>& aTargets)>& aOnTargets);
+
+    // reverse reach of the sources and/or headers, computed on the snapshot.
+    // aoHasCosts is true if the .ninja_log durations were available
+    std::vector<graph::Hotspots::Entry> getHotspots(datas::TargetTypeMask aTypeMask, datas::EdgeKindMask aEdgeKinds, bool& aoHasCosts);
+
+    // the outputs of aOutputs not built by ninja as inputs of another one, computed on the snapshot
+    std::vector<std::string> getRebuildSet(const std::vector<std::string>& aOutputs);
+
+    // digest of the files each binary selected by apMatcher is made of, computed on the snapshot.
+    // the file hashes are cached in KUNAI_HASHES_NAME
+    std::vector<graph::Fingerprint::Entry> getFingerprints(datas::EdgeKindMask aEdgeKinds, const utils::PathMatcher* apMatcher = nullptr);
 
 private:
-    // Check if database needs rebuild based on file date and SHA1 changes
+    // the loader is shared by the requests of the serve daemon, each query starts without the errors of the previous ones
+    void m_clearError();
+
+    // Check if database needs rebuild based on file date and content hash changes
     void m_checkStatus(const std::filesystem::path& buildDir, bool aForceRebuild, Loader::Status& aoStatus);
 
-    // compute the sah1 of a file
-    std::string m_computeSha1(const std::filesystem::path& filepath);
+    // algorithm and hashes stored in the database. the databases without hash_algo used sha1
+    datas::HashAlgo m_getStoredHashes(std::string& aoBuildNinjaHash, std::string& aoNinjaDepsHash);
 
     // load ninja file in database
     bool m_load(const std::filesystem::path& buildDir, bool aForceRebuild);
+
+    // stat stamps of the build files
+    utils::FreshnessStamp m_getFreshnessStamp(const std::filesystem::path& buildDir);
+
+    // open the database read only, if not already opened
+    bool m_openDb();
+
+    // check the database against the build files, rebuild it if needed
+    bool m_update(const std::filesystem::path& buildDir, bool aForceRebuild);
+
+    // build a shadow database and swap it with the current one
+    bool m_rebuild(const std::filesystem::path& buildDir, const Loader::Status& aStatus);
+
+    // stamp of the database content, used to check the snapshot freshness
+    std::string m_getGraphStamp();
+
+    // write the graph snapshot from the database
+    bool m_writeSnapshot(const std::filesystem::path& buildDir);
+
+    // build duration of each snapshot node from the .ninja_log, empty if not available
+    std::vector<double> m_getNodesCosts();
+
+    // map the graph snapshot, rewrite it if missing or stale
+    bool m_openSnapshot(const std::filesystem::path& buildDir);
+
+    // map the closure index of the snapshot, compute it if missing or stale
+    bool m_openClosure(const std::filesystem::path& buildDir);
 };
 
 }  // namespace ninja
@@ -5,8 +5,14 @@
 #include <ezlibs/ezStr.hpp>
 #include <ezlibs/ezTime.hpp>
 
+#include <app/utils/paths.h>
+#include <app/utils/substring_matcher.h>
+#include <app/utils/path_matcher.h>
+
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <type_traits>
 
 namespace fs = std::filesystem;
 
@@ -37,11 +43,99 @@ bool DataBase::open(const fs::path& aDbPath) {
     }
     mp_db.reset(ptr);
 
-    return m_createSchema();
+    // the ddl is only needed for a new or outdated database
+    if ((getSchemaVersion() != KUNAI_SCHEMA_VERSION) && !m_createSchema()) {
+        return false;
+    }
+    m_hasTrigramIndex = m_hasTable("targets_trigrams");
+    m_hasSuffixIndex = m_hasTable("target_suffixes");
+    return true;
+}
+
+bool DataBase::openReadOnly(const fs::path& aDbPath) {
+    close();
+
+    // no write means no RESERVED lock, concurrent readers never serialize
+    sqlite3* ptr = nullptr;
+    int rc = sqlite3_open_v2(aDbPath.string().c_str(), &ptr, SQLITE_OPEN_READONLY, nullptr);
+    if (rc != SQLITE_OK) {
+        m_error << sqlite3_errmsg(ptr);
+        sqlite3_close(ptr);
+        return false;
+    }
+    mp_db.reset(ptr);
+
+    // the whole file is mapped and cached, up to 256 MB
+    std::error_code ec;
+    const auto dbSize = static_cast<uint64_t>(fs::file_size(aDbPath, ec));
+    if (!ec) {
+        const auto cacheKb = std::min<uint64_t>(dbSize / 1024U + 1024U, 262144U);
+        const auto pragmas = "PRAGMA mmap_size = " + std::to_string(dbSize) + "; PRAGMA cache_size = -" + std::to_string(cacheKb) + ";";
+        m_exec(pragmas.c_str());
+    }
+
+    m_exec("PRAGMA temp_store = MEMORY;");  // the seeds tables of the queries
+
+    m_hasTrigramIndex = m_hasTable("targets_trigrams");
+    m_hasSuffixIndex = m_hasTable("target_suffixes");
+    return true;
+}
+
+bool DataBase::openForBulkLoad(const fs::path& aDbPath) {
+    close();
+
+    sqlite3* ptr = nullptr;
+    int rc = sqlite3_open(aDbPath.string().c_str(), &ptr);
+    if (rc != SQLITE_OK) {
+        m_error << sqlite3_errmsg(ptr);
+        sqlite3_close(ptr);
+        return false;
+    }
+    mp_db.reset(ptr);
+
+    // the file is a private shadow copy, swapped in only once complete,
+    // so journaling and syncing are useless during the load.
+    // page_size must be set before the first table is created
+    const char* pragmas = R"(
+        PRAGMA page_size = 16384;
+        PRAGMA journal_mode = OFF;
+        PRAGMA synchronous = OFF;
+        PRAGMA locking_mode = EXCLUSIVE;
+        PRAGMA temp_store = MEMORY;
+        PRAGMA cache_size = -65536; -- 64 MB
+    )";
+    if (!m_exec(pragmas)) {
+        return false;
+    }
+
+    // indexes are created by createIndexes() once the datas are loaded
+    return m_createTables();
 }
 
 void DataBase::close() {
     mp_db.reset();
+    m_hasTrigramIndex = false;
+    m_hasSuffixIndex = false;
+}
+
+bool DataBase::isOpened() const {
+    return mp_db != nullptr;
+}
+
+int32_t DataBase::getSchemaVersion() const {
+    int32_t ret{};
+    sqlite3_stmt* stmt{nullptr};
+    if ((mp_db != nullptr) && (sqlite3_prepare_v2(mp_db.get(), "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK)) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            ret = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return ret;
+}
+
+bool DataBase::setSchemaVersion(int32_t aVersion) {
+    return m_exec(("PRAGMA user_version = " + std::to_string(aVersion) + ";").c_str());
 }
 
 std::string DataBase::getError() const {
@@ -63,6 +157,37 @@ bool DataBase::rollback() {
     return m_exec("ROLLBACK;");
 }
 
+bool DataBase::createIndexes() {
+    if (!m_createIndexes()) {
+        return false;
+    }
+    // not fatal, pointed queries fall back on a full scan of targets.
+    // a partial index is dropped, the readers would take its table for a complete one
+    m_hasTrigramIndex = m_createTrigramIndex();
+    if (!m_hasTrigramIndex) {
+        m_exec("DROP TABLE IF EXISTS targets_trigrams;");
+    }
+    m_hasSuffixIndex = m_createSuffixIndex();
+    if (!m_hasSuffixIndex) {
+        m_exec("DROP TABLE IF EXISTS target_suffixes;");
+    }
+    return true;
+}
+
+bool DataBase::storeCounters() {
+    // one pass by table, the counters are read back by getStats
+    const char* sql = R"(
+        INSERT OR REPLACE INTO metadata (key, value)
+            SELECT 'count_type_' || type, COUNT(*) FROM targets GROUP BY type;
+        INSERT OR REPLACE INTO metadata (key, value)
+            SELECT 'count_links', COUNT(*) FROM links;
+        INSERT OR REPLACE INTO metadata (key, value)
+            SELECT 'count_links_kind_' || bit, COUNT(*) FROM links, (SELECT 1 AS bit UNION SELECT 2 UNION SELECT 4 UNION SELECT 8 UNION SELECT 16)
+            WHERE kinds & bit GROUP BY bit;
+    )";
+    return m_exec(sql);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Data insertion
 
@@ -81,7 +206,7 @@ void DataBase::insertNinjaBuildLink(const ninja::IBuildWriter::BuildLink& link)
             const auto depType = m_getTargetType("", dep);
             if (depType != TargetType::NOT_SUPPORTED) {
                 const int64_t depId = m_getOrCreateNode(dep, depType);
-                m_insertLink(targetId, depId);
+                m_insertLink(targetId, depId, EdgeKind::EXPLICIT);
             }
         }
         // les .so sont en implcities
@@ -89,14 +214,14 @@ void DataBase::insertNinjaBuildLink(const ninja::IBuildWriter::BuildLink& link)
             const auto depType = m_getTargetType("", dep);
             if (depType != TargetType::NOT_SUPPORTED) {
                 const int64_t depId = m_getOrCreateNode(dep, depType);
-                m_insertLink(targetId, depId);
+                m_insertLink(targetId, depId, EdgeKind::IMPLICIT);
             }
         }
         for (const auto& dep : link.order_only) {
             const auto depType = m_getTargetType("", dep);
             if (depType != TargetType::NOT_SUPPORTED) {
                 const int64_t depId = m_getOrCreateNode(dep, depType);
-                m_insertLink(targetId, depId);
+                m_insertLink(targetId, depId, EdgeKind::ORDER_ONLY);
             }
         }
     }
@@ -110,7 +235,7 @@ void DataBase::insertNinjaDepsEntry(const ninja::IDepsWriter::DepsEntry& deps) {
             const auto depType = m_getTargetType("", dep);
             if (depType != TargetType::NOT_SUPPORTED) {
                 const int64_t depId = m_getOrCreateNode(dep, depType);
-                m_insertLink(targetId, depId);
+                m_insertLink(targetId, depId, EdgeKind::DEPS_LOG);
             }
         }
     }
@@ -130,7 +255,7 @@ void DataBase::insertCMakeTarget(const cmake::ITargetWriter::Target& target) {
 
         if (sourceType != TargetType::NOT_SUPPORTED) {
             const int64_t sourceId = m_getOrCreateNode(source, sourceType);
-            m_insertLink(targetId, sourceId);
+            m_insertLink(targetId, sourceId, EdgeKind::CMAKE);
         }
     }
 }
@@ -201,6 +326,9 @@ void DataBase::setMetadata(const std::string& key, const std::string& value) {
 
 std::string DataBase::getMetadata(const std::string& key) {
     std::string ret;
+    if (mp_db == nullptr) {
+        return ret;  // no database yet
+    }
     sqlite3_stmt* stmt{nullptr};
     if (sqlite3_prepare_v2(mp_db.get(), "SELECT value FROM metadata WHERE key = ?", -1, &stmt, nullptr) == SQLITE_OK) {
         sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
@@ -221,31 +349,35 @@ DataBase::Stats DataBase::getStats() const {
 
     const char* sql = R"(
         SELECT
-            (SELECT COUNT(*) FROM links) AS links,
-            (SELECT COUNT(*) FROM targets WHERE type = 1) AS sources,
-            (SELECT COUNT(*) FROM targets WHERE type = 2) AS headers,
-            (SELECT COUNT(*) FROM targets WHERE type = 3) AS objects,
-            (SELECT COUNT(*) FROM targets WHERE type = 4) AS libraries,
-            (SELECT COUNT(*) FROM targets WHERE type = 5) AS binaries,
-            (SELECT COUNT(*) FROM targets WHERE type = 6) AS inputs,
-            (SELECT CAST(value AS REAL) FROM metadata WHERE key = "perf_db_filling_ms"),
-            (SELECT CAST(value AS REAL) FROM metadata WHERE key = "perf_db_loading_ms"),
-            (SELECT CAST(value AS REAL) FROM metadata WHERE key = "perf_query_ms")
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_links"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_links_kind_1"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_links_kind_2"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_links_kind_4"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_links_kind_8"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_links_kind_16"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_type_1"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_type_2"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_type_3"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_type_4"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_type_5"),
+            (SELECT CAST(value AS INTEGER) FROM metadata WHERE key = "count_type_6")
     )";
 
     sqlite3_stmt* stmt{nullptr};
     if (sqlite3_prepare_v2(mp_db.get(), sql, -1, &stmt, nullptr) == SQLITE_OK) {
         if (sqlite3_step(stmt) == SQLITE_ROW) {
             stats.counters.deps = sqlite3_column_int64(stmt, 0);
-            stats.counters.sources = sqlite3_column_int64(stmt, 1);
-            stats.counters.headers = sqlite3_column_int64(stmt, 2);
-            stats.counters.objects = sqlite3_column_int64(stmt, 3);
-            stats.counters.libraries = sqlite3_column_int64(stmt, 4);
-            stats.counters.binaries = sqlite3_column_int64(stmt, 5);
-            stats.counters.inputs = sqlite3_column_int64(stmt, 6);
-            stats.timings.dbFilling = sqlite3_column_double(stmt, 7);
-            stats.timings.dbLoading = sqlite3_column_double(stmt, 8);
-            stats.timings.query = sqlite3_column_double(stmt, 9);
+            stats.counters.explicitDeps = sqlite3_column_int64(stmt, 1);
+            stats.counters.implicitDeps = sqlite3_column_int64(stmt, 2);
+            stats.counters.orderOnlyDeps = sqlite3_column_int64(stmt, 3);
+            stats.counters.depsLogDeps = sqlite3_column_int64(stmt, 4);
+            stats.counters.cmakeDeps = sqlite3_column_int64(stmt, 5);
+            stats.counters.sources = sqlite3_column_int64(stmt, 6);
+            stats.counters.headers = sqlite3_column_int64(stmt, 7);
+            stats.counters.objects = sqlite3_column_int64(stmt, 8);
+            stats.counters.libraries = sqlite3_column_int64(stmt, 9);
+            stats.counters.binaries = sqlite3_column_int64(stmt, 10);
+            stats.counters.inputs = sqlite3_column_int64(stmt, 11);
         }
         sqlite3_finalize(stmt);
     }
@@ -253,60 +385,69 @@ DataBase::Stats DataBase::getStats() const {
     return stats;
 }
 
-std::vector<std::string> DataBase::getAllTargetsByType(TargetType aTargetType) const {
-    std::vector<std::string> ret;
+// sql list of the types of a mask, ex : (1,2,5)
+static std::string getTypesSqlList(TargetTypeMask aTypeMask) {
+    std::string ret = "(";
+    for (int32_t type = static_cast<int32_t>(TargetType::SOURCE); type <= static_cast<int32_t>(TargetType::INPUT); ++type) {
+        if (hasType(aTypeMask, static_cast<TargetType>(type))) {
+            if (ret.size() > 1U) ret += ",";
+            ret += std::to_string(type);
+        }
+    }
+    return ret + ")";
+}
+
+TargetsByType DataBase::getAllTargets(TargetTypeMask aTypeMask, const utils::PathMatcher* apMatcher) const {
+    TargetsByType ret;
+    const auto sql = "SELECT path, type FROM targets WHERE type IN " + getTypesSqlList(aTypeMask);
     sqlite3_stmt* stmt{nullptr};
-    if (sqlite3_prepare_v2(mp_db.get(), "SELECT path FROM targets WHERE type = ?", -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_int(stmt, 1, static_cast<int32_t>(aTargetType));
+    if (sqlite3_prepare_v2(mp_db.get(), sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            ret.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+            const auto type = static_cast<TargetType>(sqlite3_column_int(stmt, 1));
+            const auto* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            if ((path != nullptr) && ((apMatcher == nullptr) || apMatcher->isMatching(path))) {
+                ret[type].push_back(path);
+            }
         }
         sqlite3_finalize(stmt);
     }
     return ret;
 }
 
-std::vector<std::string> DataBase::getPointedTargetsByType(const std::vector<std::string>& sourcePaths, TargetType aTargetType) const {
-    std::vector<std::string> ret;
+TargetsByType DataBase::getPointedTargets(
+    const std::vector<std::string>& sourcePaths,
+    TargetTypeMask aTypeMask,
+    const datas::SeedOptions& aSeedOptions,
+    const datas::TraversalOptions& aTraversalOptions,
+    const utils::PathMatcher* apMatcher) const {
+    TargetsByType ret;
 
-    if (sourcePaths.empty()) {
+    if (sourcePaths.empty() || (m_fillSeeds(sourcePaths, aSeedOptions) == 0U)) {
         return ret;
     }
 
     std::string sql = R"(
         WITH RECURSIVE pointed(id) AS (
-            SELECT id FROM targets WHERE )";
-
-    // Add conditions for each source path
-    for (size_t i = 0; i < sourcePaths.size(); ++i) {
-        if (i > 0) sql += " OR ";
-        sql += "path = ? OR path LIKE ?";
-    }
-
-    sql += R"(
+            SELECT id FROM temp.seed_ids
             UNION
             SELECT l.from_id 
             FROM links l
             JOIN pointed a ON l.to_id = a.id
+            WHERE (l.kinds & )";
+    sql += std::to_string(aTraversalOptions.edgeKinds);
+    sql += R"() != 0
         )
-        SELECT DISTINCT path FROM targets 
+        SELECT DISTINCT path, type FROM targets 
         WHERE id IN (SELECT id FROM pointed) 
-          AND type = ?
-    )";
+          AND type IN )";
+    sql += getTypesSqlList(aTypeMask);
 
     sqlite3_stmt* stmt{nullptr};
     if (sqlite3_prepare_v2(mp_db.get(), sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        int paramIdx = 1;
-        for (const auto& path : sourcePaths) {
-            sqlite3_bind_text(stmt, paramIdx++, path.c_str(), -1, SQLITE_TRANSIENT);
-            std::string pattern = "%" + path + "%";
-            sqlite3_bind_text(stmt, paramIdx++, pattern.c_str(), -1, SQLITE_TRANSIENT);
-        }
-        sqlite3_bind_int(stmt, paramIdx, static_cast<int32_t>(aTargetType));
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             const char* val = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            if (val) {
-                ret.push_back(val);
+            if ((val != nullptr) && ((apMatcher == nullptr) || apMatcher->isMatching(val))) {
+                ret[static_cast<TargetType>(sqlite3_column_int(stmt, 1))].push_back(val);
             }
         }
         sqlite3_finalize(stmt);
@@ -315,6 +456,35 @@ std::vector<std::string> DataBase::getPointedTargetsByType(const std::vector<std
     return ret;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Graph export
+
+void DataBase::forEachTarget(const std::function<void(int64_t aId, const char* aPath, TargetType aType)>& aCallback) const {
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(mp_db.get(), "SELECT id, path, type FROM targets ORDER BY id", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            aCallback(
+                sqlite3_column_int64(stmt, 0),  //
+                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                static_cast<TargetType>(sqlite3_column_int(stmt, 2)));
+        }
+        sqlite3_finalize(stmt);
+    }
+}
+
+void DataBase::forEachLink(const std::function<void(int64_t aFromId, int64_t aToId, EdgeKindMask aKinds)>& aCallback) const {
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(mp_db.get(), "SELECT from_id, to_id, kinds FROM links ORDER BY from_id, to_id", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            aCallback(
+                sqlite3_column_int64(stmt, 0),  //
+                sqlite3_column_int64(stmt, 1),
+                static_cast<EdgeKindMask>(sqlite3_column_int(stmt, 2)));
+        }
+        sqlite3_finalize(stmt);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Private
 
@@ -330,6 +500,10 @@ bool DataBase::m_exec(const char* sql) {
 }
 
 bool DataBase::m_createSchema() {
+    return m_createTables() && m_createIndexes();
+}
+
+bool DataBase::m_createTables() {
     const char* schema = R"(
         CREATE TABLE IF NOT EXISTS targets (
             id INTEGER PRIMARY KEY,
@@ -340,6 +514,7 @@ bool DataBase::m_createSchema() {
         CREATE TABLE IF NOT EXISTS links (
             from_id INTEGER NOT NULL,
             to_id INTEGER NOT NULL,
+            kinds INTEGER NOT NULL DEFAULT 1, -- EdgeKind bits, 1=EXPLICIT, 2=IMPLICIT, 4=ORDER_ONLY, 8=DEPS_LOG, 16=CMAKE
             PRIMARY KEY (from_id, to_id),
             FOREIGN KEY (from_id) REFERENCES targets(id),
             FOREIGN KEY (to_id) REFERENCES targets(id)
@@ -356,7 +531,12 @@ bool DataBase::m_createSchema() {
             type INTEGER NOT NULL, -- 1=SOURCE, 2=HEADER, 6=INPUT, 4=LIBRARY
             UNIQUE(ext, type)
         );
+    )";
+    return m_exec(schema);
+}
 
+bool DataBase::m_createIndexes() {
+    const char* indexes = R"(
         CREATE INDEX IF NOT EXISTS idx_links_to ON links(to_id);
         CREATE INDEX IF NOT EXISTS idx_links_from ON links(from_id);
         CREATE INDEX IF NOT EXISTS idx_targets_source ON targets(type) WHERE type = 1; -- the source type
@@ -366,7 +546,165 @@ bool DataBase::m_createSchema() {
         CREATE INDEX IF NOT EXISTS idx_targets_binary ON targets(type) WHERE type = 5; -- the binary type
         CREATE INDEX IF NOT EXISTS idx_targets_input ON targets(type) WHERE type = 6; -- the input type
     )";
-    return m_exec(schema);
+    return m_exec(indexes);
+}
+
+bool DataBase::m_createTrigramIndex() {
+    // external content table : only the trigram index is stored, the paths stay in targets.
+    // the trigram tokenizer is case insensitive, like the LIKE operator
+    const char* sql = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS targets_trigrams USING fts5(path, content='targets', content_rowid='id', tokenize='trigram');
+        INSERT INTO targets_trigrams(targets_trigrams) VALUES('rebuild');
+    )";
+    return sqlite3_exec(mp_db.get(), sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+bool DataBase::m_createSuffixIndex() {
+    // reversed paths : a path suffix becomes an indexed prefix
+    if (!m_exec("CREATE TABLE IF NOT EXISTS target_suffixes (rpath TEXT NOT NULL, id INTEGER NOT NULL); DELETE FROM target_suffixes;")) {
+        return false;
+    }
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(mp_db.get(), "INSERT INTO target_suffixes (rpath, id) VALUES (?, ?)", -1, &stmt, nullptr) != SQLITE_OK) {
+        m_error << sqlite3_errmsg(mp_db.get());
+        return false;
+    }
+    forEachTarget([stmt](int64_t aId, const char* aPath, TargetType /*aType*/) {
+        const auto rpath = utils::paths::reverse(aPath != nullptr ? aPath : "");
+        sqlite3_bind_text(stmt, 1, rpath.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 2, aId);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    });
+    sqlite3_finalize(stmt);
+    return m_exec("CREATE INDEX IF NOT EXISTS idx_target_suffixes ON target_suffixes(rpath);");
+}
+
+bool DataBase::m_hasTable(const char* aTableName) const {
+    bool ret = false;
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(mp_db.get(), "SELECT 1 FROM sqlite_master WHERE name = ?", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, aTableName, -1, SQLITE_STATIC);
+        ret = (sqlite3_step(stmt) == SQLITE_ROW);
+        sqlite3_finalize(stmt);
+    }
+    return ret;
+}
+
+size_t DataBase::m_fillSeeds(const std::vector<std::string>& aSourcePaths, const datas::SeedOptions& aSeedOptions) const {
+    // temp tables are private to the connection, even a read only one can fill them
+    const char* prepare = R"(
+        CREATE TEMP TABLE IF NOT EXISTS seed_ids (id INTEGER PRIMARY KEY);
+        DELETE FROM temp.seed_ids;
+        BEGIN;
+    )";
+    sqlite3_stmt* insertStmt{nullptr};
+    if ((sqlite3_exec(mp_db.get(), prepare, nullptr, nullptr, nullptr) != SQLITE_OK) ||
+        (sqlite3_prepare_v2(mp_db.get(), "INSERT OR IGNORE INTO temp.seed_ids (id) VALUES (?)", -1, &insertStmt, nullptr) != SQLITE_OK)) {
+        sqlite3_exec(mp_db.get(), "ROLLBACK;", nullptr, nullptr, nullptr);
+        return 0U;
+    }
+    size_t ret{};
+    auto insertSeed = [this, insertStmt, &ret](int64_t aId) {
+        sqlite3_bind_int64(insertStmt, 1, aId);
+        if (sqlite3_step(insertStmt) == SQLITE_DONE) {
+            ret += static_cast<size_t>(sqlite3_changes(mp_db.get()));
+        }
+        sqlite3_reset(insertStmt);
+    };
+
+    if (aSeedOptions.match == PathMatch::SUFFIX) {
+        for (const auto id : m_getSeedIdsBySuffix(aSourcePaths, aSeedOptions)) {
+            insertSeed(id);
+        }
+    } else {
+        // the files are literal sub-strings ('_' and '%' included), matched in one read of each path
+        const utils::SubStringMatcher matcher(aSourcePaths);
+        sqlite3_stmt* stmt{nullptr};
+        if (m_hasTrigramIndex && (aSourcePaths.size() <= TRIGRAM_LOOKUPS_MAX) &&
+            (sqlite3_prepare_v2(mp_db.get(), "SELECT rowid, path FROM targets_trigrams WHERE path LIKE ?", -1, &stmt, nullptr) == SQLITE_OK)) {
+            // few files : the candidates of the trigram index of each file
+            for (const auto& path : aSourcePaths) {
+                const auto pattern = "%" + path + "%";
+                sqlite3_bind_text(stmt, 1, pattern.c_str(), -1, SQLITE_TRANSIENT);
+                while (sqlite3_step(stmt) == SQLITE_ROW) {
+                    const auto* candidate = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+                    if ((candidate != nullptr) && matcher.isMatching(candidate)) {
+                        insertSeed(sqlite3_column_int64(stmt, 0));
+                    }
+                }
+                sqlite3_reset(stmt);
+            }
+            sqlite3_finalize(stmt);
+        } else {
+            // many files : one scan of the paths
+            forEachTarget([&matcher, &insertSeed](int64_t aId, const char* aPath, TargetType /*aType*/) {
+                if ((aPath != nullptr) && matcher.isMatching(aPath)) {
+                    insertSeed(aId);
+                }
+            });
+        }
+    }
+    sqlite3_finalize(insertStmt);
+    sqlite3_exec(mp_db.get(), "COMMIT;", nullptr, nullptr, nullptr);
+    return ret;
+}
+
+std::vector<int64_t> DataBase::m_getSeedIdsBySuffix(const std::vector<std::string>& aSourcePaths, const datas::SeedOptions& aSeedOptions) const {
+    std::vector<int64_t> ret;
+    for (const auto& file : aSourcePaths) {
+        const auto ids = utils::paths::resolveBySuffix<int64_t>(
+            file,
+            aSeedOptions,
+            [this](const std::string& aSuffix) { return m_lookupSuffix(aSuffix); },
+            [this](int64_t aId) { return m_getPath(aId); });
+        ret.insert(ret.end(), ids.begin(), ids.end());
+    }
+    std::sort(ret.begin(), ret.end());
+    ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+    return ret;
+}
+
+std::vector<int64_t> DataBase::m_lookupSuffix(const std::string& aSuffix) const {
+    std::vector<int64_t> ret;
+    sqlite3_stmt* stmt{nullptr};
+    if (m_hasSuffixIndex) {
+        // the suffix itself, or the suffix preceded by a '/' ('0' follows '/' in ascii)
+        const auto rsuffix = utils::paths::reverse(aSuffix);
+        const auto lower = rsuffix + "/";
+        const auto upper = rsuffix + "0";
+        if (sqlite3_prepare_v2(mp_db.get(), "SELECT id FROM target_suffixes WHERE rpath = ? OR (rpath >= ? AND rpath < ?)", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, rsuffix.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, lower.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 3, upper.c_str(), -1, SQLITE_TRANSIENT);
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                ret.push_back(sqlite3_column_int64(stmt, 0));
+            }
+            sqlite3_finalize(stmt);
+        }
+    } else {
+        // database built without the suffix index
+        forEachTarget([&ret, &aSuffix](int64_t aId, const char* aPath, TargetType /*aType*/) {
+            if ((aPath != nullptr) && utils::paths::endsWithComponents(aPath, aSuffix)) {
+                ret.push_back(aId);
+            }
+        });
+    }
+    return ret;
+}
+
+std::string DataBase::m_getPath(int64_t aId) const {
+    std::string ret;
+    sqlite3_stmt* stmt{nullptr};
+    if (sqlite3_prepare_v2(mp_db.get(), "SELECT path FROM targets WHERE id = ?", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, aId);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* val = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            if (val) ret = val;
+        }
+        sqlite3_finalize(stmt);
+    }
+    return ret;
 }
 
 TargetType DataBase::m_getTargetType(const std::string& aRule, const std::string& aTarget) const {
@@ -431,11 +769,18 @@ int64_t DataBase::m_getOrCreateNode(const std::string& path, TargetType type) {
     return sqlite3_last_insert_rowid(mp_db.get());
 }
 
-void DataBase::m_insertLink(int64_t fromId, int64_t toId) {
+void DataBase::m_insertLink(int64_t fromId, int64_t toId, EdgeKind aKind) {
+    // the same link can come from several origins, the kinds are merged
     sqlite3_stmt* stmt{nullptr};
-    sqlite3_prepare_v2(mp_db.get(), "INSERT OR IGNORE INTO links (from_id, to_id) VALUES (?, ?)", -1, &stmt, nullptr);
+    sqlite3_prepare_v2(
+        mp_db.get(),
+        "INSERT INTO links (from_id, to_id, kinds) VALUES (?, ?, ?) ON CONFLICT(from_id, to_id) DO UPDATE SET kinds = kinds | excluded.kinds",
+        -1,
+        &stmt,
+        nullptr);
     sqlite3_bind_int64(stmt, 1, fromId);
     sqlite3_bind_int64(stmt, 2, toId);
+    sqlite3_bind_int(stmt, 3, static_cast<int32_t>(toMask(aKind)));
     sqlite3_step(stmt);
     sqlite3_finalize(stmt);
 }
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <sstream>
 #include <filesystem>
 #include <type_traits>
@@ -18,12 +19,21 @@ namespace kunai {
 namespace cmake {
     struct CMakeTarget;  // Forward declaration
 }
+namespace utils {
+class PathMatcher;
+}
 
 class DataBase : public ninja::IBuildWriter, public ninja::IDepsWriter, public cmake::ITargetWriter {
 public:
     struct Stats {
         struct Counter {
             int64_t deps{};
+            // links by origin, a link can be counted in several kinds
+            int64_t explicitDeps{};
+            int64_t implicitDeps{};
+            int64_t orderOnlyDeps{};
+            int64_t depsLogDeps{};
+            int64_t cmakeDeps{};
             int64_t sources{};
             int64_t headers{};
             int64_t objects{};
@@ -31,11 +41,37 @@ public:
             int64_t binaries{};
             int64_t inputs{};
         } counters;
+        struct Measure {
+            double last{};
+            double mean{};
+            size_t count{};
+        };
+        // filled from the telemetry sidecar, not from the database
         struct Timing {
-            double dbFilling{};
-            double dbLoading{};
-            double query{};
+            Measure dbFilling;
+            Measure dbLoading;
+            Measure query;
         } timings; // Ms
+        // wall and cpu times of the last rebuild phases. the parsers and the writer run concurrently
+        struct Phase {
+            Measure wall;
+            Measure cpu;
+        };
+        struct Phases {
+            Phase parseBuild;
+            Phase parseDeps;
+            Phase parseCMake;
+            Phase parsing;  // all the parsers, wall only
+            Phase writing;  // the writer thread, from the first to the last batch
+        } phases;  // Ms
+        // batches queue between the parsers and the writer, during the last rebuild
+        struct Queue {
+            Measure batches;
+            Measure maxDepth;
+            Measure meanDepth;
+            Measure parserStall;  // Ms waiting for a free batch, the writer is behind
+            Measure writerWait;   // Ms waiting for a batch, the parsers are behind
+        } queue;
     };
 
 private:
@@ -43,6 +79,8 @@ private:
         void operator()(sqlite3* apDB);
     };
     std::unique_ptr<sqlite3, SqliteDeleter> mp_db;
+    bool m_hasTrigramIndex{false};  // targets_trigrams fts5 table is available
+    bool m_hasSuffixIndex{false};   // target_suffixes table is available
     mutable std::stringstream m_error;
 
 public:
@@ -54,13 +92,29 @@ public:
 
     // Open/create database
     bool open(const std::filesystem::path& dbPath);
+    // Open an existing database for the queries, nothing can be written
+    bool openReadOnly(const std::filesystem::path& dbPath);
+    // Open/create a database for a one shot bulk load (no journal, no sync, no indexes)
+    bool openForBulkLoad(const std::filesystem::path& dbPath);
     void close();
+    bool isOpened() const;
+
+    // Layout version of the database, stored in PRAGMA user_version
+    int32_t getSchemaVersion() const;
+    bool setSchemaVersion(int32_t aVersion);
 
     // Transaction
     bool beginTransaction();
     bool commit();
     bool rollback();
 
+    // Create the query indexes (deferred after a bulk load). false only if the required ones fail,
+    // the trigram and suffix indexes are optional
+    bool createIndexes();
+
+    // Store the counters of the stats in the metadata (once the graph is loaded)
+    bool storeCounters();
+
     // Insertions
     void clear();
     void insertNinjaBuildLink(const ninja::IBuildWriter::BuildLink& link) override;
@@ -86,8 +140,19 @@ public:
 
     // Queries
     Stats getStats() const;
-    std::vector<std::string> getAllTargetsByType(datas::TargetType aTargetType) const;
-    std::vector<std::string> getPointedTargetsByType(const std::vector<std::string>& sourcePaths, datas::TargetType aTargetType) const;
+    // apMatcher filters the paths, nullptr for all
+    datas::TargetsByType getAllTargets(datas::TargetTypeMask aTypeMask, const utils::PathMatcher* apMatcher = nullptr) const;
+    // one traversal for all the requested types
+    datas::TargetsByType getPointedTargets(
+        const std::vector<std::string>& sourcePaths,
+        datas::TargetTypeMask aTypeMask,
+        const datas::SeedOptions& aSeedOptions = {},
+        const datas::TraversalOptions& aTraversalOptions = {},
+        const utils::PathMatcher* apMatcher = nullptr) const;
+
+    // Graph export, rows are given by ascending target id
+    void forEachTarget(const std::function<void(int64_t aId, const char* aPath, datas::TargetType aType)>& aCallback) const;
+    void forEachLink(const std::function<void(int64_t aFromId, int64_t aToId, datas::EdgeKindMask aKinds)>& aCallback) const;
 
     // Infos
     std::string getError() const;
@@ -95,12 +160,28 @@ public:
 private:
     bool m_exec(const char* sql);
     bool m_createSchema();
+    bool m_createTables();
+    bool m_createIndexes();
+    // optional, depends on the fts5 availability
+    bool m_createTrigramIndex();
+    bool m_createSuffixIndex();
+    bool m_hasTable(const char* aTableName) const;
+
+    // beyond, one scan of the paths costs less than the trigram lookups of the files
+    static constexpr size_t TRIGRAM_LOOKUPS_MAX{8U};
+    // fills temp.seed_ids with the nodes matching the files, returns their count
+    size_t m_fillSeeds(const std::vector<std::string>& aSourcePaths, const datas::SeedOptions& aSeedOptions) const;
+    // ids of the nodes matching the files by path suffix
+    std::vector<int64_t> m_getSeedIdsBySuffix(const std::vector<std::string>& aSourcePaths, const datas::SeedOptions& aSeedOptions) const;
+    // ids of the nodes whose path ends with the components of aSuffix
+    std::vector<int64_t> m_lookupSuffix(const std::string& aSuffix) const;
+    std::string m_getPath(int64_t aId) const;
 
     // Check if a rule looks like an executable linker
     datas::TargetType m_getTargetType(const std::string& aRule, const std::string& aTarget) const;
 
     int64_t m_getOrCreateNode(const std::string& path, datas::TargetType type);
-    void m_insertLink(int64_t fromId, int64_t toId);
+    void m_insertLink(int64_t fromId, int64_t toId, datas::EdgeKind aKind);
 };
 
 }  // namespace kunai
@@ -0,0 +1,162 @@
+#include "staging.h"
+
+#include <app/model/model.h>
+
+#include <chrono>
+
+namespace kunai {
+
+void Staging::insertNinjaBuildLink(const ninja::IBuildWriter::BuildLink& link) {
+    m_buildLinks.push_back(link);
+}
+
+void Staging::insertNinjaDepsEntry(const ninja::IDepsWriter::DepsEntry& deps) {
+    m_depsEntries.push_back(deps);
+}
+
+void Staging::insertCMakeTarget(const cmake::ITargetWriter::Target& target) {
+    m_cmakeTargets.push_back(target);
+}
+
+void Staging::addFileExtension(const std::string& ext, datas::TargetType type) {
+    m_fileExtensions.emplace_back(ext, type);
+}
+
+datas::TargetType Staging::getFileExtensionType(const std::string& /*ext*/) const {
+    return datas::TargetType::NOT_SUPPORTED;
+}
+
+size_t Staging::getRecordsCount() const {
+    return m_buildLinks.size() + m_depsEntries.size() + m_cmakeTargets.size() + m_fileExtensions.size();
+}
+
+void Staging::mergeInto(DataBase& arDb) {
+    for (const auto& ext : m_fileExtensions) {
+        arDb.addFileExtension(ext.first, ext.second);
+    }
+    for (const auto& link : m_buildLinks) {
+        arDb.insertNinjaBuildLink(link);
+    }
+    for (const auto& deps : m_depsEntries) {
+        arDb.insertNinjaDepsEntry(deps);
+    }
+    for (const auto& target : m_cmakeTargets) {
+        arDb.insertCMakeTarget(target);
+    }
+    m_fileExtensions.clear();
+    m_buildLinks.clear();
+    m_depsEntries.clear();
+    m_cmakeTargets.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// StagingChannel
+
+StagingChannel::StagingChannel(size_t aBatchesCount, size_t aBatchRecords)
+    : m_filled(aBatchesCount), m_free(aBatchesCount), m_batchRecords(aBatchRecords) {
+    // the queues can hold all the batches, a push never fails
+    for (size_t i = 0U; i < m_free.capacity(); ++i) {
+        auto pBatch = std::make_unique<Staging>();
+        m_free.tryPush(pBatch);
+    }
+}
+
+void StagingChannel::insertNinjaBuildLink(const ninja::IBuildWriter::BuildLink& link) {
+    m_getCurrent().insertNinjaBuildLink(link);
+    m_onRecord();
+}
+
+void StagingChannel::insertNinjaDepsEntry(const ninja::IDepsWriter::DepsEntry& deps) {
+    m_getCurrent().insertNinjaDepsEntry(deps);
+    m_onRecord();
+}
+
+void StagingChannel::insertCMakeTarget(const cmake::ITargetWriter::Target& target) {
+    m_getCurrent().insertCMakeTarget(target);
+    m_onRecord();
+}
+
+void StagingChannel::addFileExtension(const std::string& ext, datas::TargetType type) {
+    m_getCurrent().addFileExtension(ext, type);
+    m_onRecord();
+}
+
+datas::TargetType StagingChannel::getFileExtensionType(const std::string& /*ext*/) const {
+    return datas::TargetType::NOT_SUPPORTED;
+}
+
+void StagingChannel::close() {
+    if (mp_current != nullptr && mp_current->getRecordsCount() > 0U) {
+        m_send();
+    }
+    if (m_stats.batchesCount > 0U) {
+        m_stats.meanDepth = static_cast<double>(m_depthsSum) / static_cast<double>(m_stats.batchesCount);
+    }
+    m_closed.store(true, std::memory_order_release);
+}
+
+bool StagingChannel::pop(std::unique_ptr<Staging>& aoBatch) {
+    uint32_t spins{};
+    std::chrono::steady_clock::time_point start;
+    while (!m_filled.tryPop(aoBatch)) {
+        // the last batch is pushed before the close flag
+        if (m_closed.load(std::memory_order_acquire)) {
+            if (m_filled.tryPop(aoBatch)) {
+                break;
+            }
+            return false;
+        }
+        if (spins == 0U) {
+            start = std::chrono::steady_clock::now();
+        }
+        utils::backoff(spins);
+    }
+    if (spins > 0U) {
+        m_stats.consumerWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
+
+void StagingChannel::recycle(std::unique_ptr<Staging> apBatch) {
+    m_free.tryPush(apBatch);
+}
+
+StagingChannel::Stats StagingChannel::getStats() const {
+    return m_stats;
+}
+
+Staging& StagingChannel::m_getCurrent() {
+    if (mp_current == nullptr) {
+        uint32_t spins{};
+        std::chrono::steady_clock::time_point start;
+        while (!m_free.tryPop(mp_current)) {
+            if (spins == 0U) {
+                start = std::chrono::steady_clock::now();
+            }
+            utils::backoff(spins);
+        }
+        if (spins > 0U) {
+            m_stats.producerStallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    return *mp_current;
+}
+
+void StagingChannel::m_onRecord() {
+    if (mp_current->getRecordsCount() >= m_batchRecords) {
+        m_send();
+    }
+}
+
+void StagingChannel::m_send() {
+    m_filled.tryPush(mp_current);
+    mp_current.reset();  // moved in the queue
+    ++m_stats.batchesCount;
+    const size_t depth = m_filled.size();
+    m_depthsSum += depth;
+    if (depth > m_stats.maxDepth) {
+        m_stats.maxDepth = depth;
+    }
+}
+
+}  // namespace kunai
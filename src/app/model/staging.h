@@ -0,0 +1,109 @@
+#pragma once
+
+/*
+ * Staging - in memory records of one parser
+ *
+ * Each parser of a rebuild writes in its own staging, so the parsers run
+ * concurrently without sharing anything. The stagings are then merged into
+ * the database by a single writer, in the order of the sequential load.
+ *
+ * StagingChannel streams the records of one parser to the writer thread as
+ * batches of stagings : the filled batches go through a bounded queue, the
+ * writer gives them back once merged. With all the batches in flight the
+ * parser waits, this is the backpressure.
+ */
+
+#include <app/headers/defs.hpp>
+#include <app/interfaces/i_cmake_entry_wirter.h>
+#include <app/interfaces/i_ninja_build_writer.h>
+#include <app/interfaces/i_ninja_deps_writer.h>
+#include <app/utils/spsc_queue.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace kunai {
+
+class DataBase;
+class Staging : public ninja::IBuildWriter, public ninja::IDepsWriter, public cmake::ITargetWriter {
+private:
+    std::vector<ninja::IBuildWriter::BuildLink> m_buildLinks;
+    std::vector<ninja::IDepsWriter::DepsEntry> m_depsEntries;
+    std::vector<cmake::ITargetWriter::Target> m_cmakeTargets;
+    std::vector<std::pair<std::string, datas::TargetType>> m_fileExtensions;
+
+public:
+    Staging() = default;
+    Staging(const Staging&) = delete;
+    Staging& operator=(const Staging&) = delete;
+
+    // IBuildWriter
+    void insertNinjaBuildLink(const ninja::IBuildWriter::BuildLink& link) override;
+
+    // IDepsWriter
+    void insertNinjaDepsEntry(const ninja::IDepsWriter::DepsEntry& deps) override;
+
+    // ITargetWriter. the types of the paths are only known by the database, at merge
+    void insertCMakeTarget(const cmake::ITargetWriter::Target& target) override;
+    void addFileExtension(const std::string& ext, datas::TargetType type) override;
+    datas::TargetType getFileExtensionType(const std::string& ext) const override;
+
+    size_t getRecordsCount() const;
+
+    // write the records in arDb then clear them. the memory is kept for the next batch
+    void mergeInto(DataBase& arDb);
+};
+
+class StagingChannel : public ninja::IBuildWriter, public ninja::IDepsWriter, public cmake::ITargetWriter {
+public:
+    // read once both sides are done
+    struct Stats {
+        size_t batchesCount{};
+        size_t maxDepth{};       // filled batches waiting for the writer
+        double meanDepth{};      // sampled at each push
+        double producerStallMs{};  // parser waiting for a free batch
+        double consumerWaitMs{};   // writer waiting for a filled batch
+    };
+
+private:
+    utils::SpscQueue<std::unique_ptr<Staging>> m_filled;  // parser -> writer
+    utils::SpscQueue<std::unique_ptr<Staging>> m_free;    // writer -> parser
+    std::unique_ptr<Staging> mp_current;
+    size_t m_batchRecords{};
+    std::atomic<bool> m_closed{false};
+    Stats m_stats;
+    size_t m_depthsSum{};
+
+public:
+    StagingChannel(size_t aBatchesCount, size_t aBatchRecords);
+    StagingChannel(const StagingChannel&) = delete;
+    StagingChannel& operator=(const StagingChannel&) = delete;
+
+    // producer side, the writer interfaces of the parser
+    void insertNinjaBuildLink(const ninja::IBuildWriter::BuildLink& link) override;
+    void insertNinjaDepsEntry(const ninja::IDepsWriter::DepsEntry& deps) override;
+    void insertCMakeTarget(const cmake::ITargetWriter::Target& target) override;
+    void addFileExtension(const std::string& ext, datas::TargetType type) override;
+    datas::TargetType getFileExtensionType(const std::string& ext) const override;
+
+    // producer side. sends the pending batch, the parser must call it even on failure
+    void close();
+
+    // consumer side. false once closed and drained
+    bool pop(std::unique_ptr<Staging>& aoBatch);
+
+    // consumer side. gives a merged batch back to the parser
+    void recycle(std::unique_ptr<Staging> apBatch);
+
+    Stats getStats() const;
+
+private:
+    Staging& m_getCurrent();
+    void m_onRecord();
+    void m_send();
+};
+
+}  // namespace kunai
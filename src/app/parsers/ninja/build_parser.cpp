@@ -7,8 +7,10 @@ namespace ninja {
 
 std::pair<std::unique_ptr<BuildParser>, std::string> BuildParser::create(
     const std::string& aFilePathName,
-    IBuildWriter& arDbWriter) {
+    IBuildWriter& arDbWriter,
+    datas::HashAlgo aHashAlgo) {
     auto pRet = std::make_unique<BuildParser>(arDbWriter);
+    pRet->m_hashAlgo = aHashAlgo;
     std::string error;
     if (!pRet->m_parse(aFilePathName)) {
         error = pRet->getError();
@@ -25,6 +27,10 @@ std::string BuildParser::getError() const {  //
     return m_error.str();
 }
 
+const std::string& BuildParser::getContentHash() const {
+    return m_contentHash;
+}
+
 std::string BuildParser::m_getDirectory(const std::string& aFilePathName) {
     size_t pos = aFilePathName.find_last_of("/\\");
     if (pos == std::string::npos) {
@@ -55,10 +61,12 @@ bool BuildParser::m_parseFile(const std::string& aFilePathName, bool aOpeningOpt
     if (m_parsedFiles.count(aFilePathName)) {
         return true;
     }
+    const bool isRoot = m_parsedFiles.empty();
     m_parsedFiles.insert(aFilePathName);
 
-    std::ifstream file(aFilePathName);
-    if (!file.is_open()) {
+    // the bytes are hashed as they are read, the file is read once
+    utils::HashedFileBuf fileBuf(m_hashAlgo);
+    if (!fileBuf.open(aFilePathName)) {
         if (aOpeningOptional) {
             return true;
         }
@@ -66,13 +74,14 @@ bool BuildParser::m_parseFile(const std::string& aFilePathName, bool aOpeningOpt
         return false;
     }
 
+    std::istream file(&fileBuf);
     std::string line;
-    while (std::getline(file, line)) {
+    while (m_getLine(file, line)) {
         // Handle line continuations ($)
         while (!line.empty() && line.back() == '$') {
             line.pop_back();
             std::string next;
-            if (std::getline(file, next)) {
+            if (m_getLine(file, next)) {
                 m_trim(next);
                 line += next;
             }
@@ -124,12 +133,26 @@ bool BuildParser::m_parseFile(const std::string& aFilePathName, bool aOpeningOpt
         if (m_startsWith(line, "rule ")) {
             // Skip indented lines
             while (file.peek() == ' ') {
-                std::getline(file, line);
+                m_getLine(file, line);
             }
             continue;
         }
     }
 
+    if (isRoot) {
+        m_contentHash = fileBuf.finalize();
+    }
+
+    return true;
+}
+
+bool BuildParser::m_getLine(std::istream& arStream, std::string& aoLine) {
+    if (!std::getline(arStream, aoLine)) {
+        return false;
+    }
+    if (!aoLine.empty() && aoLine.back() == '\r') {
+        aoLine.pop_back();
+    }
     return true;
 }
 
@@ -201,19 +224,17 @@ std::string BuildParser::m_expandVars(const std::string& aInput, const std::unor
 }
 
 // Format: build targets: rule inputs | implicit || order_only
-void BuildParser::m_parseBuildStatement(const std::string& aLine, std::ifstream& arFile) {
+void BuildParser::m_parseBuildStatement(const std::string& aLine, std::istream& arStream) {
     std::string stmt = aLine.substr(6);  // Skip "build "
 
     ez::str::replaceString(stmt, "\\", "/");
 
     // Read indented local variables
     std::unordered_map<std::string, std::string> localVars = m_globalVars;
-    std::streampos savedPos = arFile.tellg();
     std::string varLine;
 
-    while (arFile.peek() == ' ') {
-        savedPos = arFile.tellg();
-        if (!std::getline(arFile, varLine)) {
+    while (arStream.peek() == ' ') {
+        if (!m_getLine(arStream, varLine)) {
             break;
         }
         size_t eq = varLine.find('=');
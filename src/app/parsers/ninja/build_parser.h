@@ -2,6 +2,7 @@
 
 #include <app/headers/defs.hpp>
 #include <app/interfaces/i_ninja_build_writer.h>
+#include <app/utils/file_hash.h>
 
 #include <string>
 #include <vector>
@@ -16,12 +17,18 @@ namespace ninja {
 
 class BuildParser {
 public:
-    static std::pair<std::unique_ptr<BuildParser>, std::string> create(const std::string& aFilePathName, IBuildWriter& arDbWriter);
+    // the file is hashed with aHashAlgo while it's parsed, see getContentHash
+    static std::pair<std::unique_ptr<BuildParser>, std::string> create(
+        const std::string& aFilePathName,
+        IBuildWriter& arDbWriter,
+        datas::HashAlgo aHashAlgo = datas::HashAlgo::FAST128);
 
 private:
     std::stringstream m_error;
     std::string m_baseDir;
     IBuildWriter& mr_dbWriter;
+    datas::HashAlgo m_hashAlgo{datas::HashAlgo::FAST128};
+    std::string m_contentHash;  // of the root file, the included files are not hashed
     std::unordered_map<std::string, std::string> m_globalVars;
     std::unordered_set<std::string> m_parsedFiles;  // Avoid parsing same file twice
 
@@ -31,17 +38,22 @@ public:
     BuildParser& operator=(const BuildParser&) = delete;
     std::string getError() const;
 
+    // hex digest of the bytes of the root file, as they were parsed
+    const std::string& getContentHash() const;
+
 private:
     std::string m_getDirectory(const std::string& aFilePathName);
     std::string m_resolvePath(const std::string& aPath);
     bool m_parse(const std::string& aFilePathName);
     // aOpeningOptional by ex if its a non existing include we not want to stop the parsing
     bool m_parseFile(const std::string& aFilePathName, bool aOpeningOptional);
+    // getline without the \r of the CRLF line endings
+    bool m_getLine(std::istream& arStream, std::string& aoLine);
     void m_trim(std::string& arStr);
     bool m_startsWith(const std::string& aStr, const std::string& aPrefix);
     void m_parseVariable(const std::string& aLine, std::unordered_map<std::string, std::string>& aVars);
     std::string m_expandVars(const std::string& aInput, const std::unordered_map<std::string, std::string>& aVars);
-    void m_parseBuildStatement(const std::string& aLine, std::ifstream& arFile);
+    void m_parseBuildStatement(const std::string& aLine, std::istream& arStream);
 };
 
 }  // namespace ninja
@@ -5,8 +5,10 @@ namespace ninja {
 
 std::pair<std::unique_ptr<DepsParser>, std::string> DepsParser::create(
     const std::string& aFilePathName,
-    IDepsWriter& arDbWriter) {
+    IDepsWriter& arDbWriter,
+    datas::HashAlgo aHashAlgo) {
     auto pRet = std::make_unique<DepsParser>(arDbWriter);
+    pRet->m_hashAlgo = aHashAlgo;
     std::string error;
     if (!pRet->m_parse(aFilePathName)) {
         error = pRet->getError();
@@ -22,12 +24,20 @@ std::string DepsParser::getError() const {  //
     return m_error.str();
 }
 
+const std::string& DepsParser::getContentHash() const {
+    return m_contentHash;
+}
+
 bool DepsParser::m_parse(const std::string& aFilePathName) {
     const auto bytes = ez::file::loadFileToBin(aFilePathName);
     if (bytes.empty()) {
         return false;
     }
 
+    utils::Hasher hasher(m_hashAlgo);
+    hasher.update(bytes.data(), bytes.size());
+    m_contentHash = hasher.finalize();
+
     m_binBuf.setDatas(bytes);
 
     size_t pos = 0;
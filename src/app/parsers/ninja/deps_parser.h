@@ -4,6 +4,7 @@
 
 #include <app/headers/defs.hpp>
 #include <app/interfaces/i_ninja_deps_writer.h>
+#include <app/utils/file_hash.h>
 
 #include <ezlibs/ezFile.hpp>
 #include <ezlibs/ezBinBuf.hpp>
@@ -20,13 +21,18 @@ namespace ninja {
 class DepsParser {
 public:
 
+    // the file is hashed with aHashAlgo from the loaded bytes, see getContentHash
     static std::pair<std::unique_ptr<DepsParser>, std::string> create(
-        const std::string& aFilePathName, IDepsWriter& arDbWriter);
+        const std::string& aFilePathName,
+        IDepsWriter& arDbWriter,
+        datas::HashAlgo aHashAlgo = datas::HashAlgo::FAST128);
 
 private:
     ez::BinBuf m_binBuf;
     std::stringstream m_error;
     IDepsWriter& mr_dbWriter;
+    datas::HashAlgo m_hashAlgo{datas::HashAlgo::FAST128};
+    std::string m_contentHash;
     std::vector<std::string> m_paths;                  // ID -> path
     std::unordered_map<uint32_t, size_t> m_pathIndex;  // ID -> index in m_paths
 
@@ -36,6 +42,9 @@ public:
     DepsParser& operator=(const DepsParser&) = delete;
     std::string getError() const;
 
+    // hex digest of the parsed bytes
+    const std::string& getContentHash() const;
+
 private:
     bool m_parse(const std::string& aFilePathName);
 };
@@ -0,0 +1,61 @@
+#include "log_parser.h"
+
+#include <fstream>
+#include <cstdlib>
+
+namespace kunai {
+namespace ninja {
+
+std::pair<std::unique_ptr<LogParser>, std::string> LogParser::create(const std::string& aFilePathName) {
+    auto pRet = std::make_unique<LogParser>();
+    std::string error;
+    if (!pRet->m_parse(aFilePathName)) {
+        error = pRet->getError();
+        pRet.reset();
+    }
+    return std::make_pair(std::move(pRet), error);
+}
+
+std::string LogParser::getError() const {  //
+    return m_error.str();
+}
+
+const std::unordered_map<std::string, double>& LogParser::getDurations() const {
+    return m_durations;
+}
+
+bool LogParser::m_parse(const std::string& aFilePathName) {
+    std::ifstream file(aFilePathName);
+    if (!file.is_open()) {
+        m_error << "Cannot open file: " << aFilePathName;
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || (line.rfind("# ninja log v", 0) != 0)) {
+        m_error << "Invalid signature";
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        // start, end, mtime, output, hash
+        size_t fields[4]{};
+        size_t count = 0U;
+        for (size_t pos = line.find('\t'); (pos != std::string::npos) && (count < 4U); pos = line.find('\t', pos + 1U)) {
+            fields[count++] = pos;
+        }
+        if (count < 4U) {
+            continue;  // truncated line, ex : interrupted build
+        }
+        const auto start = std::strtod(line.c_str(), nullptr);
+        const auto end = std::strtod(line.c_str() + fields[0] + 1U, nullptr);
+        m_durations[line.substr(fields[2] + 1U, fields[3] - fields[2] - 1U)] = end - start;
+    }
+    return true;
+}
+
+}  // namespace ninja
+}  // namespace kunai
@@ -0,0 +1,36 @@
+#pragma once
+
+// .ninja_log : a text header "# ninja log vN" then one line per built output
+//   start_ms \t end_ms \t mtime \t output \t command_hash
+// an output rebuilt several times has several lines, the last one is the latest build
+
+#include <string>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+
+namespace kunai {
+namespace ninja {
+
+class LogParser {
+public:
+    static std::pair<std::unique_ptr<LogParser>, std::string> create(const std::string& aFilePathName);
+
+private:
+    std::stringstream m_error;
+    std::unordered_map<std::string, double> m_durations;  // output -> last build duration in ms
+
+public:
+    LogParser() = default;
+    LogParser(const LogParser&) = delete;
+    LogParser& operator=(const LogParser&) = delete;
+    std::string getError() const;
+
+    const std::unordered_map<std::string, double>& getDurations() const;
+
+private:
+    bool m_parse(const std::string& aFilePathName);
+};
+
+}  // namespace ninja
+}  // namespace kunai
@@ -0,0 +1,44 @@
+#include "cpu_timer.h"
+
+#include <ezlibs/ezOS.hpp>
+
+#ifdef WINDOWS_OS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <ctime>
+#endif
+
+namespace kunai {
+namespace utils {
+
+double getThreadCpuMs() {
+#ifdef WINDOWS_OS
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0.0;
+    }
+    auto toTicks = [](const FILETIME& aTime) {  // 100 ns ticks
+        return (static_cast<unsigned long long>(aTime.dwHighDateTime) << 32U) | aTime.dwLowDateTime;
+    };
+    return static_cast<double>(toTicks(kernelTime) + toTicks(userTime)) / 10000.0;
+#else
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0.0;
+    }
+    return static_cast<double>(ts.tv_sec) * 1000.0 + static_cast<double>(ts.tv_nsec) / 1000000.0;
+#endif
+}
+
+ScopedCpuTimer::ScopedCpuTimer(double& arTarget) : mr_target(arTarget), m_start(getThreadCpuMs()) {
+}
+
+ScopedCpuTimer::~ScopedCpuTimer() {
+    mr_target = getThreadCpuMs() - m_start;
+}
+
+}  // namespace utils
+}  // namespace kunai
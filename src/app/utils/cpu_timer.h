@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * CpuTimer - CPU time of the calling thread
+ *
+ * The counterpart of ez::time::ScopedTimer for the CPU time : compared to the
+ * wall time of the same scope, it shows the time spent waiting (io, locks),
+ * and across threads how much of the work overlapped.
+ */
+
+namespace kunai {
+namespace utils {
+
+// CPU time consumed by the calling thread, in ms
+double getThreadCpuMs();
+
+class ScopedCpuTimer {
+private:
+    double& mr_target;
+    double m_start{};
+
+public:
+    explicit ScopedCpuTimer(double& arTarget);
+    ~ScopedCpuTimer();
+    ScopedCpuTimer(const ScopedCpuTimer&) = delete;
+    ScopedCpuTimer& operator=(const ScopedCpuTimer&) = delete;
+};
+
+}  // namespace utils
+}  // namespace kunai
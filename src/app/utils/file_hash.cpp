@@ -0,0 +1,280 @@
+#include "file_hash.h"
+
+#include <app/utils/mapped_file.h>
+
+#include <ezlibs/ezOS.hpp>
+
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+
+namespace {
+
+constexpr uint64_t PRIME64_1{0x9E3779B185EBCA87ULL};
+constexpr uint64_t PRIME64_2{0xC2B2AE3D27D4EB4FULL};
+constexpr uint64_t PRIME64_3{0x165667B19E3779F9ULL};
+constexpr uint64_t PRIME64_4{0x85EBCA77C2B2AE63ULL};
+constexpr uint64_t PRIME64_5{0x27D4EB2F165667C5ULL};
+
+constexpr size_t STRIPE_SIZE{64U};
+constexpr size_t LANES_COUNT{STRIPE_SIZE / sizeof(uint64_t)};
+constexpr uint32_t SHA1_CHUNK_SIZE{1U << 20U};  // ez::sha1 takes 32 bits sizes
+
+inline uint64_t rotl64(uint64_t aValue, uint32_t aBits) {
+    return (aValue << aBits) | (aValue >> (64U - aBits));
+}
+
+// the digest is only compared on the same machine, the native byte order is fine
+inline uint64_t read64(const uint8_t* apDatas) {
+    uint64_t ret;
+    std::memcpy(&ret, apDatas, sizeof(ret));
+    return ret;
+}
+
+inline uint32_t read32(const uint8_t* apDatas) {
+    uint32_t ret;
+    std::memcpy(&ret, apDatas, sizeof(ret));
+    return ret;
+}
+
+inline uint64_t round64(uint64_t aAcc, uint64_t aLane) {
+    aAcc += aLane * PRIME64_2;
+    aAcc = rotl64(aAcc, 31U);
+    return aAcc * PRIME64_1;
+}
+
+inline uint64_t mergeRound64(uint64_t aAcc, uint64_t aValue) {
+    aAcc ^= round64(0U, aValue);
+    return aAcc * PRIME64_1 + PRIME64_4;
+}
+
+inline uint64_t avalanche64(uint64_t aHash) {
+    aHash ^= aHash >> 33U;
+    aHash *= PRIME64_2;
+    aHash ^= aHash >> 29U;
+    aHash *= PRIME64_3;
+    aHash ^= aHash >> 32U;
+    return aHash;
+}
+
+// merge of 4 lanes, then the tail bytes, as the xxHash64 finalization
+uint64_t finalize64(const uint64_t* apAccs, bool aHasStripes, uint64_t aSeed, const uint8_t* apTail, size_t aTailSize, uint64_t aTotalSize) {
+    uint64_t h{};
+    if (aHasStripes) {
+        h = rotl64(apAccs[0], 1U) + rotl64(apAccs[1], 7U) + rotl64(apAccs[2], 12U) + rotl64(apAccs[3], 18U);
+        for (size_t i = 0U; i < 4U; ++i) {
+            h = mergeRound64(h, apAccs[i]);
+        }
+    } else {
+        h = aSeed + PRIME64_5;
+    }
+    h += aTotalSize;
+    while (aTailSize >= 8U) {
+        h ^= round64(0U, read64(apTail));
+        h = rotl64(h, 27U) * PRIME64_1 + PRIME64_4;
+        apTail += 8U;
+        aTailSize -= 8U;
+    }
+    if (aTailSize >= 4U) {
+        h ^= static_cast<uint64_t>(read32(apTail)) * PRIME64_1;
+        h = rotl64(h, 23U) * PRIME64_2 + PRIME64_3;
+        apTail += 4U;
+        aTailSize -= 4U;
+    }
+    while (aTailSize > 0U) {
+        h ^= static_cast<uint64_t>(*apTail) * PRIME64_5;
+        h = rotl64(h, 11U) * PRIME64_1;
+        ++apTail;
+        --aTailSize;
+    }
+    return avalanche64(h);
+}
+
+std::string toHex(uint64_t aValue) {
+    static const char* digits = "0123456789abcdef";
+    std::string ret(16U, '0');
+    for (size_t i = 0U; i < 16U; ++i) {
+        ret[15U - i] = digits[aValue & 0xFU];
+        aValue >>= 4U;
+    }
+    return ret;
+}
+
+constexpr uint64_t SEED_LOW{0U};
+constexpr uint64_t SEED_HIGH{PRIME64_3};
+constexpr size_t READ_BUFFER_SIZE{1U << 20U};
+
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// Hasher
+
+Hasher::Hasher(datas::HashAlgo aAlgo) : m_algo(aAlgo) {
+    m_accs[0] = SEED_LOW + PRIME64_1 + PRIME64_2;
+    m_accs[1] = SEED_LOW + PRIME64_2;
+    m_accs[2] = SEED_LOW;
+    m_accs[3] = SEED_LOW - PRIME64_1;
+    m_accs[4] = SEED_HIGH + PRIME64_1 + PRIME64_2;
+    m_accs[5] = SEED_HIGH + PRIME64_2;
+    m_accs[6] = SEED_HIGH;
+    m_accs[7] = SEED_HIGH - PRIME64_1;
+}
+
+void Hasher::update(const uint8_t* apDatas, size_t aSize) {
+    if (apDatas == nullptr || aSize == 0U) {
+        return;
+    }
+    m_totalSize += aSize;
+    if (m_algo == datas::HashAlgo::SHA1) {
+        size_t offset{};
+        while (offset < aSize) {
+            const auto chunkSize = static_cast<uint32_t>(std::min<size_t>(aSize - offset, SHA1_CHUNK_SIZE));
+            m_sha1.add(apDatas + offset, chunkSize);
+            offset += chunkSize;
+        }
+        return;
+    }
+    // completes the pending stripe first
+    if (m_stripeSize > 0U) {
+        const size_t count = std::min(STRIPE_SIZE - m_stripeSize, aSize);
+        std::memcpy(m_stripe + m_stripeSize, apDatas, count);
+        m_stripeSize += count;
+        apDatas += count;
+        aSize -= count;
+        if (m_stripeSize < STRIPE_SIZE) {
+            return;
+        }
+        m_consumeStripes(m_stripe, 1U);
+        m_stripeSize = 0U;
+    }
+    const size_t stripesCount = aSize / STRIPE_SIZE;
+    m_consumeStripes(apDatas, stripesCount);
+    m_stripeSize = aSize - stripesCount * STRIPE_SIZE;
+    std::memcpy(m_stripe, apDatas + stripesCount * STRIPE_SIZE, m_stripeSize);
+}
+
+// 8 independent lanes per 64 bytes stripe : no dependency between the lanes,
+// the loop runs at the multiplier throughput. lanes 0-3 give the low half, 4-7 the high half
+void Hasher::m_consumeStripes(const uint8_t* apDatas, size_t aStripesCount) {
+    uint64_t accs[LANES_COUNT];
+    std::memcpy(accs, m_accs, sizeof(accs));
+    for (size_t s = 0U; s < aStripesCount; ++s, apDatas += STRIPE_SIZE) {
+        for (size_t l = 0U; l < LANES_COUNT; ++l) {
+            accs[l] = round64(accs[l], read64(apDatas + l * sizeof(uint64_t)));
+        }
+    }
+    std::memcpy(m_accs, accs, sizeof(accs));
+}
+
+std::string Hasher::finalize() {
+    if (m_algo == datas::HashAlgo::SHA1) {
+        m_sha1.finalize();
+        return m_sha1.getHex();
+    }
+    const bool hasStripes = (m_totalSize >= STRIPE_SIZE);
+    const uint64_t low = finalize64(m_accs, hasStripes, SEED_LOW, m_stripe, m_stripeSize, m_totalSize);
+    uint64_t high = finalize64(m_accs + 4U, hasStripes, SEED_HIGH, m_stripe, m_stripeSize, m_totalSize);
+    // the halves see the same bytes, each one depends on both
+    high ^= avalanche64(low + PRIME64_5);
+    return toHex(high) + toHex(low);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HashedFileBuf
+
+HashedFileBuf::HashedFileBuf(datas::HashAlgo aAlgo) : m_hasher(aAlgo) {
+}
+
+HashedFileBuf::~HashedFileBuf() {
+    if (mp_file != nullptr) {
+        std::fclose(mp_file);
+    }
+}
+
+bool HashedFileBuf::open(const fs::path& aFilePath) {
+#ifdef WINDOWS_OS
+    mp_file = _wfopen(aFilePath.c_str(), L"rb");
+#else
+    mp_file = std::fopen(aFilePath.c_str(), "rb");
+#endif
+    if (mp_file == nullptr) {
+        return false;
+    }
+    m_buffer.resize(READ_BUFFER_SIZE);
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+    return true;
+}
+
+HashedFileBuf::int_type HashedFileBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    if (mp_file == nullptr) {
+        return traits_type::eof();
+    }
+    const size_t readCount = std::fread(m_buffer.data(), 1U, m_buffer.size(), mp_file);
+    if (readCount == 0U) {
+        return traits_type::eof();
+    }
+    m_hasher.update(reinterpret_cast<const uint8_t*>(m_buffer.data()), readCount);
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + readCount);
+    return traits_type::to_int_type(*gptr());
+}
+
+std::string HashedFileBuf::finalize() {
+    return m_hasher.finalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FileHash
+
+std::string FileHash::compute(const fs::path& aFilePath, datas::HashAlgo aAlgo) {
+    std::error_code ec;
+    if (!fs::exists(aFilePath, ec)) {
+        return {};
+    }
+    auto tmp_pFile = MappedFile::create(aFilePath);
+    if (tmp_pFile.first == nullptr) {
+        return {};
+    }
+    Hasher hasher(aAlgo);
+    hasher.update(tmp_pFile.first->getDatas(), tmp_pFile.first->size());
+    return hasher.finalize();
+}
+
+std::pair<std::string, std::string> FileHash::computePair(const fs::path& aFirstPath, const fs::path& aSecondPath, datas::HashAlgo aAlgo) {
+    std::pair<std::string, std::string> ret;
+    std::thread secondThread([&ret, &aSecondPath, aAlgo]() { ret.second = compute(aSecondPath, aAlgo); });
+    ret.first = compute(aFirstPath, aAlgo);
+    secondThread.join();
+    return ret;
+}
+
+std::string FileHash::getName(datas::HashAlgo aAlgo) {
+    switch (aAlgo) {
+        case datas::HashAlgo::SHA1: return "sha1";
+        case datas::HashAlgo::FAST128:
+        default: break;
+    }
+    return "fast128";
+}
+
+bool FileHash::parseName(const std::string& aName, datas::HashAlgo& aoAlgo) {
+    if (aName == "fast128") {
+        aoAlgo = datas::HashAlgo::FAST128;
+        return true;
+    }
+    if (aName == "sha1") {
+        aoAlgo = datas::HashAlgo::SHA1;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace utils
+}  // namespace kunai
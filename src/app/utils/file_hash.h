@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+ * FileHash - content hash of a file for change detection
+ *
+ * The file is memory mapped and hashed in place, it's never copied in memory.
+ * FAST128 is a non cryptographic hash : 8 lanes of 64 bits, mixed with the
+ * xxHash64 round, finalized in two 64 bits halves. SHA1 is kept to validate
+ * the databases built before the hash was selectable.
+ *
+ * Hasher is the incremental form, fed by the parsers with the buffers they read,
+ * HashedFileBuf a stream buffer hashing the bytes of a file as they are read.
+ */
+
+#include <app/headers/defs.hpp>
+
+#include <ezlibs/ezSha.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <streambuf>
+#include <filesystem>
+
+namespace kunai {
+namespace utils {
+
+class Hasher {
+private:
+    datas::HashAlgo m_algo{datas::HashAlgo::FAST128};
+    ez::sha1 m_sha1;
+    uint64_t m_accs[8]{};
+    uint8_t m_stripe[64]{};  // pending bytes of an incomplete stripe
+    size_t m_stripeSize{};
+    uint64_t m_totalSize{};
+
+public:
+    explicit Hasher(datas::HashAlgo aAlgo);
+
+    void update(const uint8_t* apDatas, size_t aSize);
+
+    // hex digest of all the bytes given to update
+    std::string finalize();
+
+private:
+    void m_consumeStripes(const uint8_t* apDatas, size_t aStripesCount);
+};
+
+class HashedFileBuf : public std::streambuf {
+private:
+    std::FILE* mp_file{nullptr};
+    std::vector<char> m_buffer;
+    Hasher m_hasher;
+
+public:
+    explicit HashedFileBuf(datas::HashAlgo aAlgo);
+    ~HashedFileBuf() override;
+    HashedFileBuf(const HashedFileBuf&) = delete;
+    HashedFileBuf& operator=(const HashedFileBuf&) = delete;
+
+    // opened in binary mode, the hash is the one of the bytes on disk
+    bool open(const std::filesystem::path& aFilePath);
+
+    // hex digest of the bytes read. the stream must have been read until its end
+    std::string finalize();
+
+protected:
+    int_type underflow() override;
+};
+
+class FileHash {
+public:
+    // hex digest of the file, empty if the file is missing or unreadable
+    static std::string compute(const std::filesystem::path& aFilePath, datas::HashAlgo aAlgo);
+
+    // hex digests of two files, hashed concurrently
+    static std::pair<std::string, std::string> computePair(
+        const std::filesystem::path& aFirstPath,
+        const std::filesystem::path& aSecondPath,
+        datas::HashAlgo aAlgo);
+
+    // name stored in the metadata and used by the command line
+    static std::string getName(datas::HashAlgo aAlgo);
+
+    // false if the name is unknown
+    static bool parseName(const std::string& aName, datas::HashAlgo& aoAlgo);
+};
+
+}  // namespace utils
+}  // namespace kunai
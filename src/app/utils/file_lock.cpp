@@ -0,0 +1,132 @@
+#include "file_lock.h"
+
+#include <ezlibs/ezOS.hpp>
+
+#include <chrono>
+#include <thread>
+
+#ifdef WINDOWS_OS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+
+std::pair<std::unique_ptr<FileLock>, std::string> FileLock::create(const fs::path& aFilePath, uint32_t aTimeoutMs) {
+    auto pRet = std::make_unique<FileLock>();
+    std::string error;
+    if (!pRet->m_lock(aFilePath, aTimeoutMs)) {
+        error = pRet->getError();
+        pRet.reset();
+    }
+    return std::make_pair(std::move(pRet), error);
+}
+
+FileLock::~FileLock() {
+    m_close();
+}
+
+std::string FileLock::getError() const {
+    return m_error.str();
+}
+
+double FileLock::getWaitedMs() const {
+    return m_waitedMs;
+}
+
+bool FileLock::hasWaited() const {
+    return m_waited;
+}
+
+bool FileLock::m_lock(const fs::path& aFilePath, uint32_t aTimeoutMs) {
+    if (!m_open(aFilePath)) {
+        return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::milliseconds(aTimeoutMs);
+    bool busy{false};
+    while (!m_tryLock(busy)) {
+        if (!busy) {
+            m_error << "Cannot lock file: " << aFilePath.string();
+            return false;
+        }
+        m_waited = true;
+        if (std::chrono::steady_clock::now() >= deadline) {
+            m_error << "Timeout after " << aTimeoutMs << " ms waiting for the lock " << aFilePath.string();
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    m_waitedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+#ifdef WINDOWS_OS
+
+bool FileLock::m_open(const fs::path& aFilePath) {
+    HANDLE file = CreateFileW(
+        aFilePath.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        m_error << "Cannot open file: " << aFilePath.string();
+        return false;
+    }
+    mp_fileHandle = file;
+    return true;
+}
+
+bool FileLock::m_tryLock(bool& aoBusy) {
+    OVERLAPPED overlapped{};
+    if (LockFileEx(static_cast<HANDLE>(mp_fileHandle), LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+        return true;
+    }
+    aoBusy = (GetLastError() == ERROR_LOCK_VIOLATION);
+    return false;
+}
+
+void FileLock::m_close() {
+    if (mp_fileHandle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mp_fileHandle));  // releases the lock
+        mp_fileHandle = nullptr;
+    }
+}
+
+#else
+
+bool FileLock::m_open(const fs::path& aFilePath) {
+    m_fd = ::open(aFilePath.string().c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        m_error << "Cannot open file: " << aFilePath.string();
+        return false;
+    }
+    return true;
+}
+
+bool FileLock::m_tryLock(bool& aoBusy) {
+    if (::flock(m_fd, LOCK_EX | LOCK_NB) == 0) {
+        return true;
+    }
+    aoBusy = (errno == EWOULDBLOCK) || (errno == EINTR);
+    return false;
+}
+
+void FileLock::m_close() {
+    if (m_fd >= 0) {
+        ::close(m_fd);  // releases the lock
+        m_fd = -1;
+    }
+}
+
+#endif
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * FileLock - exclusive advisory lock on a file, shared between processes
+ *
+ * flock on unix, LockFileEx on win32. The lock is released when the object
+ * is destroyed, or by the system if the process dies.
+ * create() waits for the lock up to a timeout and reports the time waited.
+ */
+
+#include <string>
+#include <memory>
+#include <sstream>
+#include <cstdint>
+#include <filesystem>
+
+namespace kunai {
+namespace utils {
+
+class FileLock {
+public:
+    // the file is created if missing
+    static std::pair<std::unique_ptr<FileLock>, std::string> create(const std::filesystem::path& aFilePath, uint32_t aTimeoutMs);
+
+private:
+    std::stringstream m_error;
+    double m_waitedMs{};
+    bool m_waited{false};  // the lock was held by another process at the first attempt
+    void* mp_fileHandle{nullptr};  // win32 only
+    int32_t m_fd{-1};              // unix only
+
+public:
+    FileLock() = default;
+    ~FileLock();
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    std::string getError() const;
+
+    // time spent waiting for the lock
+    double getWaitedMs() const;
+    bool hasWaited() const;
+
+private:
+    bool m_lock(const std::filesystem::path& aFilePath, uint32_t aTimeoutMs);
+    bool m_open(const std::filesystem::path& aFilePath);
+    // one attempt. aoBusy is true if the lock is held by another process
+    bool m_tryLock(bool& aoBusy);
+    void m_close();
+};
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,115 @@
+#include "file_stamp.h"
+
+#include <ezlibs/ezOS.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#ifdef WINDOWS_OS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+
+#ifdef WINDOWS_OS
+
+FileStamp FileStamp::get(const fs::path& aFilePath) {
+    FileStamp ret;
+    WIN32_FILE_ATTRIBUTE_DATA datas{};
+    if (GetFileAttributesExW(aFilePath.wstring().c_str(), GetFileExInfoStandard, &datas)) {
+        ret.exists = true;
+        ret.size = (static_cast<uint64_t>(datas.nFileSizeHigh) << 32U) | datas.nFileSizeLow;
+        // 100 ns ticks
+        const auto ticks = (static_cast<uint64_t>(datas.ftLastWriteTime.dwHighDateTime) << 32U) | datas.ftLastWriteTime.dwLowDateTime;
+        ret.mtimeNs = static_cast<int64_t>(ticks * 100U);
+    }
+    return ret;
+}
+
+#else
+
+FileStamp FileStamp::get(const fs::path& aFilePath) {
+    FileStamp ret;
+    struct stat st{};
+    if (::stat(aFilePath.string().c_str(), &st) == 0) {
+        ret.exists = true;
+        ret.inode = static_cast<uint64_t>(st.st_ino);
+        ret.size = static_cast<uint64_t>(st.st_size);
+#ifdef APPLE_OS
+        ret.mtimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+        ret.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+    }
+    return ret;
+}
+
+#endif
+
+bool FileStamp::operator==(const FileStamp& aOther) const {
+    return (exists == aOther.exists) && (inode == aOther.inode) && (size == aOther.size) && (mtimeNs == aOther.mtimeNs);
+}
+
+bool FileStamp::operator!=(const FileStamp& aOther) const {
+    return !(*this == aOther);
+}
+
+static std::istream& operator>>(std::istream& arStream, FileStamp& aoStamp) {
+    return arStream >> aoStamp.exists >> aoStamp.inode >> aoStamp.size >> aoStamp.mtimeNs;
+}
+
+static std::ostream& operator<<(std::ostream& arStream, const FileStamp& aStamp) {
+    return arStream << aStamp.exists << ' ' << aStamp.inode << ' ' << aStamp.size << ' ' << aStamp.mtimeNs;
+}
+
+bool FreshnessStamp::load(const fs::path& aFilePath) {
+    std::ifstream file(aFilePath);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string graph;
+    if (!(file >> schemaVersion >> buildNinja >> ninjaDeps >> graph)) {
+        return false;
+    }
+    graphStamp = graph;
+    return true;
+}
+
+bool FreshnessStamp::save(const fs::path& aFilePath) const {
+    std::ostringstream content;
+    content << schemaVersion << '\n' << buildNinja << '\n' << ninjaDeps << '\n' << graphStamp << '\n';
+    fs::path tmpFilePath = aFilePath;
+    tmpFilePath += ".tmp";
+    {
+        std::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << content.str();
+        if (!file.good()) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmpFilePath, aFilePath, ec);
+    if (ec) {
+        fs::remove(tmpFilePath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool FreshnessStamp::isSameState(const FreshnessStamp& aOther) const {
+    return (schemaVersion == aOther.schemaVersion) && (buildNinja == aOther.buildNinja) && (ninjaDeps == aOther.ninjaDeps);
+}
+
+}  // namespace utils
+}  // namespace kunai
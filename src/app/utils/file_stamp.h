@@ -0,0 +1,48 @@
+#pragma once
+
+/*
+ * FileStamp - identity of a file state from a single stat call
+ *
+ * (inode, size, mtime in ns) changes whenever the file is rewritten or replaced.
+ * The FreshnessStamp saved next to the database gathers the stamps of build.ninja
+ * and .ninja_deps of the last check, so an unchanged build dir is detected
+ * with two stat calls, without opening the database.
+ */
+
+#include <string>
+#include <cstdint>
+#include <filesystem>
+
+namespace kunai {
+namespace utils {
+
+struct FileStamp {
+    uint64_t inode{};
+    uint64_t size{};
+    int64_t mtimeNs{};
+    bool exists{false};
+
+    // stamp of aFilePath, exists is false if the file is missing
+    static FileStamp get(const std::filesystem::path& aFilePath);
+
+    bool operator==(const FileStamp& aOther) const;
+    bool operator!=(const FileStamp& aOther) const;
+};
+
+struct FreshnessStamp {
+    int32_t schemaVersion{};
+    FileStamp buildNinja;
+    FileStamp ninjaDeps;
+    std::string graphStamp;  // content stamp of the database (see Loader)
+
+    // false if the file is missing or unreadable
+    bool load(const std::filesystem::path& aFilePath);
+    // written aside then renamed
+    bool save(const std::filesystem::path& aFilePath) const;
+
+    // same schema and same files, the graph stamp is not compared
+    bool isSameState(const FreshnessStamp& aOther) const;
+};
+
+}  // namespace utils
+}  // namespace kunai
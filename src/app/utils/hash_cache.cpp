@@ -0,0 +1,107 @@
+#include "hash_cache.h"
+
+#include <app/utils/file_hash.h>
+
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+
+HashCache::HashCache(datas::HashAlgo aAlgo) : m_algo(aAlgo) {
+}
+
+datas::HashAlgo HashCache::getAlgo() const {
+    return m_algo;
+}
+
+bool HashCache::load(const fs::path& aFilePath) {
+    std::ifstream file(aFilePath);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    datas::HashAlgo algo{};
+    if (!std::getline(file, line) || !FileHash::parseName(line, algo) || (algo != m_algo)) {
+        return false;
+    }
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        Entry entry;
+        std::string path;
+        if (ss >> entry.stamp.inode >> entry.stamp.size >> entry.stamp.mtimeNs >> entry.hash) {
+            ss.get();  // separator, the path can hold spaces
+            if (std::getline(ss, path) && !path.empty()) {
+                entry.stamp.exists = true;
+                m_entries[path] = std::move(entry);
+            }
+        }
+    }
+    return true;
+}
+
+bool HashCache::save(const fs::path& aFilePath) {
+    if (!m_changed) {
+        return true;
+    }
+    std::ostringstream content;
+    content << FileHash::getName(m_algo) << '\n';
+    for (const auto& it : m_entries) {
+        const auto& stamp = it.second.stamp;
+        content << stamp.inode << ' ' << stamp.size << ' ' << stamp.mtimeNs << ' ' << it.second.hash << ' ' << it.first << '\n';
+    }
+    fs::path tmpFilePath = aFilePath;
+    tmpFilePath += ".tmp";
+    {
+        std::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << content.str();
+        if (!file.good()) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmpFilePath, aFilePath, ec);
+    if (ec) {
+        fs::remove(tmpFilePath, ec);
+        return false;
+    }
+    m_changed = false;
+    return true;
+}
+
+bool HashCache::find(const std::string& aPath, const FileStamp& aStamp, std::string& aoHash) const {
+    const auto it = m_entries.find(aPath);
+    if ((it == m_entries.end()) || (it->second.stamp != aStamp)) {
+        return false;
+    }
+    aoHash = it->second.hash;
+    return true;
+}
+
+void HashCache::set(const std::string& aPath, const FileStamp& aStamp, const std::string& aHash) {
+    auto& entry = m_entries[aPath];
+    entry.stamp = aStamp;
+    entry.hash = aHash;
+    m_changed = true;
+}
+
+void HashCache::retain(const std::vector<std::string>& aPaths) {
+    const std::unordered_set<std::string> kept(aPaths.begin(), aPaths.end());
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (kept.count(it->first) == 0U) {
+            it = m_entries.erase(it);
+            m_changed = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+ * HashCache - content hashes of files, reused while the files are unchanged
+ *
+ * An entry is valid while its file has the FileStamp (inode, size, mtime) it was
+ * hashed with, so an unchanged file is only stat-ed, never read again.
+ * Saved as text next to the database, a first line with the hash algorithm
+ * then one line by file : <inode> <size> <mtime ns> <hash> <path>
+ * A cache of another algorithm is ignored.
+ */
+
+#include <app/headers/defs.hpp>
+#include <app/utils/file_stamp.h>
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+namespace kunai {
+namespace utils {
+
+class HashCache {
+private:
+    struct Entry {
+        FileStamp stamp;
+        std::string hash;
+    };
+    datas::HashAlgo m_algo{datas::HashAlgo::FAST128};
+    std::unordered_map<std::string, Entry> m_entries;  // by absolute path
+    bool m_changed{false};
+
+public:
+    explicit HashCache(datas::HashAlgo aAlgo);
+
+    datas::HashAlgo getAlgo() const;
+
+    // false if the file is missing, unreadable or of another algorithm
+    bool load(const std::filesystem::path& aFilePath);
+    // written aside then renamed, nothing is written if no entry changed
+    bool save(const std::filesystem::path& aFilePath);
+
+    // the hash of aPath if it was computed with aStamp. safe to call concurrently
+    bool find(const std::string& aPath, const FileStamp& aStamp, std::string& aoHash) const;
+    void set(const std::string& aPath, const FileStamp& aStamp, const std::string& aHash);
+    // drops the entries of the files not in aPaths
+    void retain(const std::vector<std::string>& aPaths);
+};
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,89 @@
+#include "line_reader.h"
+
+#include <ezlibs/ezOS.hpp>
+
+#ifdef WINDOWS_OS
+#include <io.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace kunai {
+namespace utils {
+
+LineReader::LineReader(int32_t aFd) : m_fd(aFd) {
+}
+
+bool LineReader::readLine(std::string& aoLine) {
+    while (!m_hasBufferedLine()) {
+        if (!m_readBlock()) {
+            break;
+        }
+    }
+    if (m_pos >= m_buffer.size()) {
+        return false;
+    }
+    auto end = m_buffer.find('\n', m_pos);
+    if (end == std::string::npos) {
+        end = m_buffer.size();  // last line without end of line
+    }
+    aoLine.assign(m_buffer, m_pos, end - m_pos);
+    if (!aoLine.empty() && aoLine.back() == '\r') {
+        aoLine.pop_back();
+    }
+    m_pos = (end < m_buffer.size()) ? end + 1U : end;
+    return true;
+}
+
+bool LineReader::hasLine() {
+    if (m_hasBufferedLine()) {
+        return true;
+    }
+#ifndef WINDOWS_OS
+    pollfd pfd{};
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    while (!m_eof && (::poll(&pfd, 1, 0) > 0)) {
+        if (!m_readBlock() || m_hasBufferedLine()) {
+            break;
+        }
+    }
+#endif
+    return m_hasBufferedLine();
+}
+
+bool LineReader::m_hasBufferedLine() const {
+    if (m_buffer.find('\n', m_pos) != std::string::npos) {
+        return true;
+    }
+    return m_eof && (m_pos < m_buffer.size());
+}
+
+bool LineReader::m_readBlock() {
+    if (m_eof) {
+        return false;
+    }
+    // the consumed lines are dropped before growing the buffer
+    m_buffer.erase(0U, m_pos);
+    m_pos = 0U;
+    char block[65536];
+#ifdef WINDOWS_OS
+    const auto count = ::_read(m_fd, block, static_cast<unsigned>(sizeof(block)));
+#else
+    auto count = ::read(m_fd, block, sizeof(block));
+    while ((count < 0) && (errno == EINTR)) {
+        count = ::read(m_fd, block, sizeof(block));
+    }
+#endif
+    if (count <= 0) {
+        m_eof = true;
+        return false;
+    }
+    m_buffer.append(block, static_cast<size_t>(count));
+    return true;
+}
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * LineReader - lines of a file descriptor, read by blocks
+ *
+ * Used by batch on stdin : hasLine() tells if a line can be read without
+ * blocking, so the queries already sent are answered together while a client
+ * sending one query at a time still gets each answer at once.
+ * On win32 only the lines of the last read block are seen as available.
+ */
+
+#include <string>
+#include <cstdint>
+
+namespace kunai {
+namespace utils {
+
+class LineReader {
+private:
+    int32_t m_fd{};
+    std::string m_buffer;
+    size_t m_pos{};  // start of the first unread line of m_buffer
+    bool m_eof{};
+
+public:
+    explicit LineReader(int32_t aFd);
+
+    // blocks until a full line or the end. false at the end
+    bool readLine(std::string& aoLine);
+    // true if readLine() would not block
+    bool hasLine();
+
+private:
+    bool m_hasBufferedLine() const;
+    // false at the end or on error
+    bool m_readBlock();
+};
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,306 @@
+#include "local_socket.h"
+
+#include <ezlibs/ezOS.hpp>
+
+#include <chrono>
+
+#ifndef WINDOWS_OS
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+
+namespace {
+
+int64_t getNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+#ifndef WINDOWS_OS
+namespace {
+
+bool fillAddress(const fs::path& aSocketPath, sockaddr_un& aoAddress, std::stringstream& arError) {
+    const auto path = aSocketPath.string();
+    if (path.size() >= sizeof(aoAddress.sun_path)) {
+        arError << "Socket path too long: " << path;
+        return false;
+    }
+    std::memset(&aoAddress, 0, sizeof(aoAddress));
+    aoAddress.sun_family = AF_UNIX;
+    std::memcpy(aoAddress.sun_path, path.c_str(), path.size() + 1U);
+    return true;
+}
+
+}  // namespace
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// LocalSocket
+
+std::pair<std::unique_ptr<LocalSocket>, std::string> LocalSocket::create(const fs::path& aSocketPath) {
+    auto pRet = std::make_unique<LocalSocket>();
+    std::string error;
+    if (!pRet->m_connect(aSocketPath)) {
+        error = pRet->getError();
+        pRet.reset();
+    }
+    return std::make_pair(std::move(pRet), error);
+}
+
+LocalSocket::LocalSocket(int32_t aFd) : m_fd(aFd) {
+}
+
+LocalSocket::~LocalSocket() {
+#ifndef WINDOWS_OS
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+std::string LocalSocket::getError() const {
+    return m_error.str();
+}
+
+void LocalSocket::setTimeout(uint32_t aTimeoutMs) {
+    m_timeoutMs = aTimeoutMs;
+}
+
+int64_t LocalSocket::m_getDeadlineMs() const {
+    return (m_timeoutMs == 0U) ? 0 : getNowMs() + m_timeoutMs;
+}
+
+bool LocalSocket::m_wait(int16_t aEvents, int64_t aDeadlineMs) {
+#ifdef WINDOWS_OS
+    (void)aEvents;
+    (void)aDeadlineMs;
+    return false;
+#else
+    if (aDeadlineMs == 0) {
+        return true;
+    }
+    while (true) {
+        const auto remainingMs = aDeadlineMs - getNowMs();
+        if (remainingMs <= 0) {
+            m_error << "Socket timeout";
+            return false;
+        }
+        pollfd pfd{};
+        pfd.fd = m_fd;
+        pfd.events = aEvents;
+        const auto count = ::poll(&pfd, 1, static_cast<int>(remainingMs));
+        if (count > 0) {
+            return true;  // ready, or an error the next call reports
+        }
+        if (count < 0 && errno != EINTR) {
+            m_error << "Cannot poll socket: " << std::strerror(errno);
+            return false;
+        }
+    }
+#endif
+}
+
+bool LocalSocket::m_connect(const fs::path& aSocketPath) {
+#ifdef WINDOWS_OS
+    (void)aSocketPath;
+    m_error << "Local sockets are not supported on win32";
+    return false;
+#else
+    sockaddr_un address{};
+    if (!fillAddress(aSocketPath, address, m_error)) {
+        return false;
+    }
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd < 0) {
+        m_error << "Cannot create socket: " << std::strerror(errno);
+        return false;
+    }
+    if (::connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        m_error << "Cannot connect to " << aSocketPath.string() << ": " << std::strerror(errno);
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool LocalSocket::writeAll(const std::string& aDatas) {
+#ifdef WINDOWS_OS
+    (void)aDatas;
+    return false;
+#else
+#ifdef MSG_NOSIGNAL
+    constexpr int flags{MSG_NOSIGNAL};  // a closed peer gives EPIPE, not SIGPIPE
+#else
+    constexpr int flags{0};
+#endif
+    const auto deadlineMs = m_getDeadlineMs();
+    size_t offset{};
+    while (offset < aDatas.size()) {
+        if (!m_wait(POLLOUT, deadlineMs)) {
+            return false;
+        }
+        const auto count = ::send(m_fd, aDatas.data() + offset, aDatas.size() - offset, flags);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            m_error << "Cannot write on socket: " << std::strerror(errno);
+            return false;
+        }
+        offset += static_cast<size_t>(count);
+    }
+    return true;
+#endif
+}
+
+bool LocalSocket::m_receive(int64_t aDeadlineMs) {
+#ifdef WINDOWS_OS
+    (void)aDeadlineMs;
+    return false;
+#else
+    char buffer[64 * 1024];
+    while (true) {
+        if (!m_wait(POLLIN, aDeadlineMs)) {
+            return false;
+        }
+        const auto count = ::recv(m_fd, buffer, sizeof(buffer), 0);
+        if (count > 0) {
+            m_pending.append(buffer, static_cast<size_t>(count));
+            return true;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        return false;
+    }
+#endif
+}
+
+bool LocalSocket::readLine(std::string& aoLine) {
+    const auto deadlineMs = m_getDeadlineMs();
+    size_t pos{};
+    while ((pos = m_pending.find('\n')) == std::string::npos) {
+        if (!m_receive(deadlineMs)) {
+            return false;
+        }
+    }
+    aoLine = m_pending.substr(0U, pos);
+    m_pending.erase(0U, pos + 1U);
+    return true;
+}
+
+bool LocalSocket::readExact(size_t aSize, std::string& aoDatas) {
+    const auto deadlineMs = m_getDeadlineMs();
+    while (m_pending.size() < aSize) {
+        if (!m_receive(deadlineMs)) {
+            return false;
+        }
+    }
+    aoDatas = m_pending.substr(0U, aSize);
+    m_pending.erase(0U, aSize);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LocalServer
+
+std::pair<std::unique_ptr<LocalServer>, std::string> LocalServer::create(const fs::path& aSocketPath) {
+    auto pRet = std::make_unique<LocalServer>();
+    std::string error;
+    if (!pRet->m_listen(aSocketPath)) {
+        error = pRet->getError();
+        pRet.reset();
+    }
+    return std::make_pair(std::move(pRet), error);
+}
+
+LocalServer::~LocalServer() {
+#ifndef WINDOWS_OS
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        std::error_code ec;
+        fs::remove(m_socketPath, ec);
+    }
+#endif
+}
+
+std::string LocalServer::getError() const {
+    return m_error.str();
+}
+
+bool LocalServer::m_listen(const fs::path& aSocketPath) {
+#ifdef WINDOWS_OS
+    (void)aSocketPath;
+    m_error << "Local sockets are not supported on win32";
+    return false;
+#else
+    sockaddr_un address{};
+    if (!fillAddress(aSocketPath, address, m_error)) {
+        return false;
+    }
+    // a socket file nobody listens on is the leftover of a killed server
+    if (fs::exists(aSocketPath)) {
+        if (LocalSocket::create(aSocketPath).first != nullptr) {
+            m_error << "A server is already listening on " << aSocketPath.string();
+            return false;
+        }
+        std::error_code ec;
+        fs::remove(aSocketPath, ec);
+    }
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        m_error << "Cannot create socket: " << std::strerror(errno);
+        return false;
+    }
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        m_error << "Cannot bind " << aSocketPath.string() << ": " << std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_socketPath = aSocketPath;
+    // owner only, before any client can connect : the requests run with the rights of the server
+    if (::chmod(aSocketPath.c_str(), S_IRUSR | S_IWUSR) != 0) {
+        m_error << "Cannot restrict " << aSocketPath.string() << ": " << std::strerror(errno);
+        return false;
+    }
+    if (::listen(m_fd, 64) != 0) {
+        m_error << "Cannot listen on " << aSocketPath.string() << ": " << std::strerror(errno);
+        return false;
+    }
+    return true;
+#endif
+}
+
+std::unique_ptr<LocalSocket> LocalServer::accept(uint32_t aTimeoutMs) {
+#ifdef WINDOWS_OS
+    (void)aTimeoutMs;
+    return nullptr;
+#else
+    pollfd pfd{};
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    if (::poll(&pfd, 1, static_cast<int>(aTimeoutMs)) <= 0) {
+        return nullptr;  // timeout or signal
+    }
+    const int fd = ::accept(m_fd, nullptr, nullptr);
+    if (fd < 0) {
+        return nullptr;
+    }
+    return std::make_unique<LocalSocket>(fd);
+#endif
+}
+
+}  // namespace utils
+}  // namespace kunai
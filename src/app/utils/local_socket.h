@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+ * LocalSocket / LocalServer - unix domain stream sockets
+ *
+ * Used between the kunai daemon (serve) and the thin clients. The socket is
+ * a file of the build dir. Not supported on win32, create() reports an error
+ * and the clients fall back to the direct mode.
+ */
+
+#include <string>
+#include <memory>
+#include <sstream>
+#include <cstdint>
+#include <filesystem>
+
+namespace kunai {
+namespace utils {
+
+class LocalSocket {
+public:
+    // connect to a listening server
+    static std::pair<std::unique_ptr<LocalSocket>, std::string> create(const std::filesystem::path& aSocketPath);
+
+private:
+    std::stringstream m_error;
+    std::string m_pending;  // bytes read after the last line
+    int32_t m_fd{-1};
+    uint32_t m_timeoutMs{};  // of each read or write call, 0 for none
+
+public:
+    LocalSocket() = default;
+    explicit LocalSocket(int32_t aFd);
+    ~LocalSocket();
+    LocalSocket(const LocalSocket&) = delete;
+    LocalSocket& operator=(const LocalSocket&) = delete;
+
+    std::string getError() const;
+
+    // a call not done within aTimeoutMs fails, so a silent peer can't block forever. 0 for no timeout
+    void setTimeout(uint32_t aTimeoutMs);
+
+    bool writeAll(const std::string& aDatas);
+    // without the '\n'. false if the peer closed before a full line
+    bool readLine(std::string& aoLine);
+    bool readExact(size_t aSize, std::string& aoDatas);
+
+private:
+    bool m_connect(const std::filesystem::path& aSocketPath);
+    // deadline of a call started now, in steady clock ms. 0 for none
+    int64_t m_getDeadlineMs() const;
+    // wait for aEvents until aDeadlineMs. false on timeout
+    bool m_wait(int16_t aEvents, int64_t aDeadlineMs);
+    // append the next received bytes to m_pending. false if closed or timed out
+    bool m_receive(int64_t aDeadlineMs);
+};
+
+class LocalServer {
+public:
+    // fails if another server is listening on aSocketPath. a stale socket file is replaced
+    static std::pair<std::unique_ptr<LocalServer>, std::string> create(const std::filesystem::path& aSocketPath);
+
+private:
+    std::stringstream m_error;
+    std::filesystem::path m_socketPath;
+    int32_t m_fd{-1};
+
+public:
+    LocalServer() = default;
+    ~LocalServer();  // the socket file is removed
+    LocalServer(const LocalServer&) = delete;
+    LocalServer& operator=(const LocalServer&) = delete;
+
+    std::string getError() const;
+
+    // next client, nullptr if none came within aTimeoutMs
+    std::unique_ptr<LocalSocket> accept(uint32_t aTimeoutMs);
+
+private:
+    bool m_listen(const std::filesystem::path& aSocketPath);
+};
+
+}  // namespace utils
+}  // namespace kunai
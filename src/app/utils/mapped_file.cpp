@@ -0,0 +1,137 @@
+#include "mapped_file.h"
+
+#include <ezlibs/ezOS.hpp>
+
+#ifdef WINDOWS_OS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+
+std::pair<std::unique_ptr<MappedFile>, std::string> MappedFile::create(const fs::path& aFilePath) {
+    auto pRet = std::make_unique<MappedFile>();
+    std::string error;
+    if (!pRet->m_open(aFilePath)) {
+        error = pRet->getError();
+        pRet.reset();
+    }
+    return std::make_pair(std::move(pRet), error);
+}
+
+MappedFile::~MappedFile() {
+    m_close();
+}
+
+const uint8_t* MappedFile::getDatas() const {
+    return mp_datas;
+}
+
+size_t MappedFile::size() const {
+    return m_size;
+}
+
+std::string MappedFile::getError() const {
+    return m_error.str();
+}
+
+#ifdef WINDOWS_OS
+
+bool MappedFile::m_open(const fs::path& aFilePath) {
+    HANDLE file = CreateFileW(aFilePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        m_error << "Cannot open file: " << aFilePath.string();
+        return false;
+    }
+    mp_fileHandle = file;
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+        m_error << "Cannot get the size of file: " << aFilePath.string();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    if (m_size == 0U) {
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        m_error << "Cannot map file: " << aFilePath.string();
+        return false;
+    }
+    mp_mapHandle = mapping;
+    mp_datas = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (mp_datas == nullptr) {
+        m_error << "Cannot map view of file: " << aFilePath.string();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::m_close() {
+    if (mp_datas != nullptr) {
+        UnmapViewOfFile(mp_datas);
+        mp_datas = nullptr;
+    }
+    if (mp_mapHandle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mp_mapHandle));
+        mp_mapHandle = nullptr;
+    }
+    if (mp_fileHandle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mp_fileHandle));
+        mp_fileHandle = nullptr;
+    }
+    m_size = 0U;
+}
+
+#else
+
+bool MappedFile::m_open(const fs::path& aFilePath) {
+    m_fd = ::open(aFilePath.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        m_error << "Cannot open file: " << aFilePath.string();
+        return false;
+    }
+    struct stat st{};
+    if (fstat(m_fd, &st) != 0) {
+        m_error << "Cannot stat file: " << aFilePath.string();
+        return false;
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size == 0U) {
+        return true;
+    }
+    void* ptr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (ptr == MAP_FAILED) {
+        m_error << "Cannot map file: " << aFilePath.string();
+        return false;
+    }
+    mp_datas = static_cast<const uint8_t*>(ptr);
+    return true;
+}
+
+void MappedFile::m_close() {
+    if (mp_datas != nullptr) {
+        munmap(const_cast<uint8_t*>(mp_datas), m_size);
+        mp_datas = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0U;
+}
+
+#endif
+
+}  // namespace utils
+}  // namespace kunai
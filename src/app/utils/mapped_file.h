@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+ * MappedFile - read only memory mapping of a whole file
+ *
+ * The mapping lives as long as the object. An empty file is valid
+ * and gives a null data pointer with a size of 0.
+ */
+
+#include <string>
+#include <memory>
+#include <sstream>
+#include <cstdint>
+#include <filesystem>
+
+namespace kunai {
+namespace utils {
+
+class MappedFile {
+public:
+    static std::pair<std::unique_ptr<MappedFile>, std::string> create(const std::filesystem::path& aFilePath);
+
+private:
+    std::stringstream m_error;
+    const uint8_t* mp_datas{nullptr};
+    size_t m_size{};
+    void* mp_fileHandle{nullptr};  // win32 only
+    void* mp_mapHandle{nullptr};   // win32 only
+    int32_t m_fd{-1};              // unix only
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* getDatas() const;
+    size_t size() const;
+    std::string getError() const;
+
+private:
+    bool m_open(const std::filesystem::path& aFilePath);
+    void m_close();
+};
+
+}  // namespace utils
+}  // namespace kunai
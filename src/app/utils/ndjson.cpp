@@ -0,0 +1,287 @@
+#include "ndjson.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+namespace kunai {
+namespace utils {
+namespace ndjson {
+
+namespace {
+
+class Reader {
+private:
+    std::string_view m_text;
+    size_t m_pos{};
+
+public:
+    explicit Reader(std::string_view aText) : m_text(aText) {}
+
+    size_t getPos() const { return m_pos; }
+    bool isEnd() {
+        m_skipSpaces();
+        return m_pos >= m_text.size();
+    }
+
+    // consumes aChar if it is the next non space char
+    bool accept(char aChar) {
+        m_skipSpaces();
+        if (m_pos < m_text.size() && m_text[m_pos] == aChar) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    char peek() {
+        m_skipSpaces();
+        return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+    }
+
+    bool readString(std::string& aoValue) {
+        aoValue.clear();
+        if (!accept('"')) {
+            return false;
+        }
+        while (m_pos < m_text.size()) {
+            const char c = m_text[m_pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                aoValue += c;
+                continue;
+            }
+            if (m_pos >= m_text.size()) {
+                return false;
+            }
+            const char e = m_text[m_pos++];
+            switch (e) {
+                case '"':
+                case '\\':
+                case '/': aoValue += e; break;
+                case 'b': aoValue += '\b'; break;
+                case 'f': aoValue += '\f'; break;
+                case 'n': aoValue += '\n'; break;
+                case 'r': aoValue += '\r'; break;
+                case 't': aoValue += '\t'; break;
+                case 'u': {
+                    uint32_t code{};
+                    if (!m_readHex4(code)) {
+                        return false;
+                    }
+                    // surrogate pair
+                    if (code >= 0xD800U && code <= 0xDBFFU && m_text.substr(m_pos, 2U) == "\\u") {
+                        m_pos += 2U;
+                        uint32_t low{};
+                        if (!m_readHex4(low) || low < 0xDC00U || low > 0xDFFFU) {
+                            return false;
+                        }
+                        code = 0x10000U + ((code - 0xD800U) << 10U) + (low - 0xDC00U);
+                    }
+                    m_appendUtf8(code, aoValue);
+                } break;
+                default: return false;
+            }
+        }
+        return false;
+    }
+
+    // number, true, false or null : the json text is kept as is
+    bool readLiteral(std::string& aoRaw) {
+        m_skipSpaces();
+        const auto start = m_pos;
+        while (m_pos < m_text.size()) {
+            const char c = m_text[m_pos];
+            if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                break;
+            }
+            ++m_pos;
+        }
+        aoRaw = std::string(m_text.substr(start, m_pos - start));
+        if (aoRaw == "true" || aoRaw == "false" || aoRaw == "null") {
+            return true;
+        }
+        char* pEnd{};
+        std::strtod(aoRaw.c_str(), &pEnd);
+        return !aoRaw.empty() && pEnd == aoRaw.c_str() + aoRaw.size();
+    }
+
+private:
+    void m_skipSpaces() {
+        while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\r' || m_text[m_pos] == '\n')) {
+            ++m_pos;
+        }
+    }
+
+    bool m_readHex4(uint32_t& aoCode) {
+        if (m_pos + 4U > m_text.size()) {
+            return false;
+        }
+        aoCode = 0U;
+        for (size_t idx = 0U; idx < 4U; ++idx) {
+            const char c = m_text[m_pos++];
+            aoCode <<= 4U;
+            if (c >= '0' && c <= '9') {
+                aoCode |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                aoCode |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                aoCode |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void m_appendUtf8(uint32_t aCode, std::string& aoStr) {
+        if (aCode < 0x80U) {
+            aoStr += static_cast<char>(aCode);
+        } else if (aCode < 0x800U) {
+            aoStr += static_cast<char>(0xC0U | (aCode >> 6U));
+            aoStr += static_cast<char>(0x80U | (aCode & 0x3FU));
+        } else if (aCode < 0x10000U) {
+            aoStr += static_cast<char>(0xE0U | (aCode >> 12U));
+            aoStr += static_cast<char>(0x80U | ((aCode >> 6U) & 0x3FU));
+            aoStr += static_cast<char>(0x80U | (aCode & 0x3FU));
+        } else {
+            aoStr += static_cast<char>(0xF0U | (aCode >> 18U));
+            aoStr += static_cast<char>(0x80U | ((aCode >> 12U) & 0x3FU));
+            aoStr += static_cast<char>(0x80U | ((aCode >> 6U) & 0x3FU));
+            aoStr += static_cast<char>(0x80U | (aCode & 0x3FU));
+        }
+    }
+};
+
+}  // namespace
+
+bool Object::parse(std::string_view aLine, std::string& aoError) {
+    m_raws.clear();
+    m_strings.clear();
+    m_arrays.clear();
+    Reader reader(aLine);
+    auto fail = [&reader, &aoError](const char* aWhat) {
+        aoError = std::string(aWhat) + " at char " + std::to_string(reader.getPos());
+        return false;
+    };
+    if (!reader.accept('{')) {
+        return fail("expected an object");
+    }
+    if (!reader.accept('}')) {
+        do {
+            std::string key;
+            if (!reader.readString(key)) {
+                return fail("expected a key");
+            }
+            if (!reader.accept(':')) {
+                return fail("expected ':'");
+            }
+            const char next = reader.peek();
+            if (next == '"') {
+                std::string value;
+                if (!reader.readString(value)) {
+                    return fail("bad string");
+                }
+                m_raws[key] = quote(value);
+                m_strings[key] = value;
+            } else if (next == '[') {
+                reader.accept('[');
+                std::vector<std::string> values;
+                if (!reader.accept(']')) {
+                    do {
+                        std::string value;
+                        if (!reader.readString(value)) {
+                            return fail("expected an array of strings");
+                        }
+                        values.push_back(value);
+                    } while (reader.accept(','));
+                    if (!reader.accept(']')) {
+                        return fail("expected ']'");
+                    }
+                }
+                std::string raw{"["};
+                for (const auto& value : values) {
+                    raw += (raw.size() > 1U ? "," : "") + quote(value);
+                }
+                m_raws[key] = raw + "]";
+                m_arrays[key] = std::move(values);
+            } else if (next == '{') {
+                return fail("nested objects are not supported");
+            } else {
+                std::string raw;
+                if (!reader.readLiteral(raw)) {
+                    return fail("bad value");
+                }
+                m_raws[key] = raw;
+            }
+        } while (reader.accept(','));
+        if (!reader.accept('}')) {
+            return fail("expected '}'");
+        }
+    }
+    if (!reader.isEnd()) {
+        return fail("trailing chars");
+    }
+    return true;
+}
+
+bool Object::has(const std::string& aKey) const {
+    return m_raws.find(aKey) != m_raws.end();
+}
+
+std::string Object::getRaw(const std::string& aKey) const {
+    const auto it = m_raws.find(aKey);
+    return it != m_raws.end() ? it->second : "null";
+}
+
+bool Object::getString(const std::string& aKey, std::string& aoValue) const {
+    const auto it = m_strings.find(aKey);
+    if (it == m_strings.end()) {
+        return false;
+    }
+    aoValue = it->second;
+    return true;
+}
+
+bool Object::getStringArray(const std::string& aKey, std::vector<std::string>& aoValues) const {
+    const auto it = m_arrays.find(aKey);
+    if (it == m_arrays.end()) {
+        return false;
+    }
+    aoValues = it->second;
+    return true;
+}
+
+std::string quote(std::string_view aStr) {
+    std::string ret;
+    ret.reserve(aStr.size() + 2U);
+    ret += '"';
+    for (const char c : aStr) {
+        switch (c) {
+            case '"': ret += "\\\""; break;
+            case '\\': ret += "\\\\"; break;
+            case '\b': ret += "\\b"; break;
+            case '\f': ret += "\\f"; break;
+            case '\n': ret += "\\n"; break;
+            case '\r': ret += "\\r"; break;
+            case '\t': ret += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20U) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                    ret += buffer;
+                } else {
+                    ret += c;
+                }
+                break;
+        }
+    }
+    ret += '"';
+    return ret;
+}
+
+}  // namespace ndjson
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * ndjson - flat json objects, one by line
+ *
+ * The batch queries are lines like {"id":1,"files":["a.h"],"types":"bl"}.
+ * Only the shapes kunai exchanges are supported : an object whose values are
+ * strings, numbers, booleans, null or arrays of strings. The raw text of each
+ * value is kept, so that an id is echoed back as it was given.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include <string_view>
+
+namespace kunai {
+namespace utils {
+namespace ndjson {
+
+class Object {
+private:
+    std::map<std::string, std::string> m_raws;  // key -> json text of the value
+    std::map<std::string, std::string> m_strings;
+    std::map<std::string, std::vector<std::string>> m_arrays;
+
+public:
+    // false if aLine is not a flat object, aoError tells why
+    bool parse(std::string_view aLine, std::string& aoError);
+
+    bool has(const std::string& aKey) const;
+    // json text of the value, "null" if absent
+    std::string getRaw(const std::string& aKey) const;
+    // false if absent or not a string
+    bool getString(const std::string& aKey, std::string& aoValue) const;
+    // false if absent or not an array of strings
+    bool getStringArray(const std::string& aKey, std::vector<std::string>& aoValues) const;
+};
+
+// quoted and escaped json string
+std::string quote(std::string_view aStr);
+
+}  // namespace ndjson
+}  // namespace utils
+}  // namespace kunai
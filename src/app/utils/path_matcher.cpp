@@ -0,0 +1,92 @@
+#include "path_matcher.h"
+
+namespace kunai {
+namespace utils {
+
+namespace {
+char toLowerAscii(char aChar) {
+    return ((aChar >= 'A') && (aChar <= 'Z')) ? static_cast<char>(aChar - 'A' + 'a') : aChar;
+}
+}  // namespace
+
+size_t PathMatcher::CharHash::operator()(char aChar) const {
+    return static_cast<size_t>(static_cast<unsigned char>(toLowerAscii(aChar)));
+}
+
+bool PathMatcher::CharEqual::operator()(char aLeft, char aRight) const {
+    return toLowerAscii(aLeft) == toLowerAscii(aRight);
+}
+
+std::pair<std::unique_ptr<PathMatcher>, std::string> PathMatcher::create(const std::string& aPatterns) {
+    auto pRet = std::make_unique<PathMatcher>();
+    if (!pRet->m_init(aPatterns)) {
+        return std::make_pair(nullptr, pRet->getError());
+    }
+    return std::make_pair(std::move(pRet), std::string());
+}
+
+bool PathMatcher::m_init(const std::string& aPatterns) {
+    std::stringstream ss(aPatterns);
+    std::string pattern;
+    while (std::getline(ss, pattern, ',')) {
+        if (pattern.compare(0U, 3U, "re:") == 0) {
+            try {
+                m_regexs.emplace_back(pattern.substr(3U), std::regex::ECMAScript | std::regex::icase | std::regex::optimize);
+            } catch (const std::regex_error& e) {
+                m_error << "Bad regex " << pattern.substr(3U) << " : " << e.what();
+                return false;
+            }
+            continue;
+        }
+        auto pGlob = std::make_unique<Glob>();
+        std::stringstream pieces(pattern);
+        std::string piece;
+        while (std::getline(pieces, piece, '*')) {
+            if (!piece.empty()) {
+                pGlob->pieces.push_back(piece);
+            }
+        }
+        // like ez::str::searchForPatternWithWildcards, a glob without pieces ("*") matches nothing
+        if (pGlob->pieces.empty()) {
+            continue;
+        }
+        for (const auto& globPiece : pGlob->pieces) {
+            pGlob->searchers.emplace_back(globPiece.begin(), globPiece.end(), CharHash(), CharEqual());
+        }
+        m_globs.push_back(std::move(pGlob));
+    }
+    return true;
+}
+
+bool PathMatcher::isMatching(std::string_view aPath) const {
+    for (const auto& pGlob : m_globs) {
+        if (m_isMatching(*pGlob, aPath)) {
+            return true;
+        }
+    }
+    for (const auto& regex : m_regexs) {
+        if (std::regex_search(aPath.begin(), aPath.end(), regex)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string PathMatcher::getError() const {
+    return m_error.str();
+}
+
+bool PathMatcher::m_isMatching(const Glob& aGlob, std::string_view aPath) {
+    auto it = aPath.begin();
+    for (const auto& searcher : aGlob.searchers) {
+        const auto found = searcher(it, aPath.end());
+        if (found.first == aPath.end()) {
+            return false;
+        }
+        it = found.second;
+    }
+    return true;
+}
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+ * PathMatcher - compiled --match patterns
+ *
+ * A comma separated list of patterns, a path matches if one of them matches :
+ *   - glob : '*' separated pieces found in order, anywhere in the path (ex : test_*)
+ *   - "re:<regex>" : ecmascript regex searched in the path (ex : re:^test_[0-9]+$)
+ * Both are case insensitive. The pieces get their Boyer-Moore-Horspool tables
+ * once, and a path is tested in place : nothing is allocated for the paths
+ * not matching. The engines test the nodes before building their path strings.
+ */
+
+#include <regex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <functional>
+#include <string_view>
+
+namespace kunai {
+namespace utils {
+
+class PathMatcher {
+public:
+    // nullptr with the error if a regex is invalid
+    static std::pair<std::unique_ptr<PathMatcher>, std::string> create(const std::string& aPatterns);
+
+private:
+    struct CharHash {
+        size_t operator()(char aChar) const;
+    };
+    struct CharEqual {
+        bool operator()(char aLeft, char aRight) const;
+    };
+    using Searcher = std::boyer_moore_horspool_searcher<std::string::const_iterator, CharHash, CharEqual>;
+    struct Glob {
+        std::vector<std::string> pieces;
+        std::vector<Searcher> searchers;  // over pieces, which is not modified once they are built
+    };
+
+    std::stringstream m_error;
+    std::vector<std::unique_ptr<Glob>> m_globs;
+    std::vector<std::regex> m_regexs;
+
+public:
+    PathMatcher() = default;
+    PathMatcher(const PathMatcher&) = delete;
+    PathMatcher& operator=(const PathMatcher&) = delete;
+
+    bool isMatching(std::string_view aPath) const;
+
+    std::string getError() const;
+
+private:
+    bool m_init(const std::string& aPatterns);
+    static bool m_isMatching(const Glob& aGlob, std::string_view aPath);
+};
+
+}  // namespace utils
+}  // namespace kunai
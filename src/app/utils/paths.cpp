@@ -0,0 +1,77 @@
+#include "paths.h"
+
+#include <ezlibs/ezOS.hpp>
+
+#include <atomic>
+#include <algorithm>
+
+#ifdef WINDOWS_OS
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+namespace paths {
+
+std::string normalize(const std::string& aPath) {
+    std::string ret(aPath);
+    std::replace(ret.begin(), ret.end(), '\\', '/');
+    while (ret.compare(0U, 2U, "./") == 0) {
+        ret.erase(0U, 2U);
+    }
+    return ret;
+}
+
+std::vector<std::string> getSuffixes(const std::string& aPath) {
+    std::vector<std::string> ret;
+    size_t start = 0U;
+    while (start < aPath.size()) {
+        if (aPath[start] != '/') {
+            ret.push_back(aPath.substr(start));
+        }
+        const auto slash = aPath.find('/', start);
+        if (slash == std::string::npos) {
+            break;
+        }
+        start = slash + 1U;
+    }
+    return ret;
+}
+
+bool endsWithComponents(std::string_view aPath, std::string_view aSuffix) {
+    if (aSuffix.empty() || aSuffix.size() > aPath.size()) {
+        return false;
+    }
+    if (aPath.compare(aPath.size() - aSuffix.size(), aSuffix.size(), aSuffix) != 0) {
+        return false;
+    }
+    return (aPath.size() == aSuffix.size()) || (aPath[aPath.size() - aSuffix.size() - 1U] == '/');
+}
+
+std::string reverse(std::string_view aPath) {
+    return std::string(aPath.rbegin(), aPath.rend());
+}
+
+std::string toAbsolute(const fs::path& aBuildDir, std::string_view aPath) {
+    fs::path path(normalize(std::string(aPath)));
+    if (path.is_relative()) {
+        path = aBuildDir / path;
+    }
+    return path.lexically_normal().generic_string();
+}
+
+fs::path getTmpPath(const fs::path& aFilePath) {
+    static std::atomic<uint32_t> s_count{0U};
+    fs::path ret = aFilePath;
+    ret += "." + std::to_string(getpid()) + "." + std::to_string(s_count++) + ".tmp";
+    return ret;
+}
+
+}  // namespace paths
+}  // namespace utils
+}  // namespace kunai
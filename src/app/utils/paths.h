@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+ * paths - helpers for the resolution of the pointed files by path suffix
+ *
+ * git gives repo relative paths (src/net/socket.cpp) while the graph holds
+ * build dir relative or absolute paths (../src/net/socket.cpp).
+ * A file is resolved to the graph nodes sharing with it the longest suffix
+ * made of whole path components. With a source root, the file is
+ * resolved exactly : root/file must be the absolute path of the node.
+ */
+
+#include <app/headers/defs.hpp>
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <string_view>
+
+namespace kunai {
+namespace utils {
+namespace paths {
+
+// '\\' to '/', without leading "./"
+std::string normalize(const std::string& aPath);
+
+// suffixes of a normalized path made of whole components, the longest first
+// ex : a/b/c.h -> {a/b/c.h, b/c.h, c.h}
+std::vector<std::string> getSuffixes(const std::string& aPath);
+
+// true if aPath is aSuffix or ends with "/" + aSuffix
+bool endsWithComponents(std::string_view aPath, std::string_view aSuffix);
+
+std::string reverse(std::string_view aPath);
+
+// lexically normal absolute path of a graph path (relative ones are relative to aBuildDir)
+std::string toAbsolute(const std::filesystem::path& aBuildDir, std::string_view aPath);
+
+// aFilePath.<pid>.<n>.tmp, a path no other process or thread writes, for a file written aside then renamed
+std::filesystem::path getTmpPath(const std::filesystem::path& aFilePath);
+
+// Resolve one file to node ids.
+// aLookup(suffix) returns the ids of the nodes whose path ends with the suffix components
+// aGetPath(id) returns the path of a node
+template <typename TId, typename TLookup, typename TGetPath>
+std::vector<TId> resolveBySuffix(const std::string& aFile, const datas::SeedOptions& aOptions, TLookup aLookup, TGetPath aGetPath) {
+    std::vector<TId> ret;
+    const auto file = normalize(aFile);
+    if (file.empty()) {
+        return ret;
+    }
+    if (!aOptions.sourceRoot.empty()) {
+        const auto expected = toAbsolute(aOptions.sourceRoot, file);
+        for (const auto id : aLookup(file)) {
+            if (toAbsolute(aOptions.buildDir, aGetPath(id)) == expected) {
+                ret.push_back(id);
+            }
+        }
+        return ret;
+    }
+    for (const auto& suffix : getSuffixes(file)) {
+        ret = aLookup(suffix);
+        if (!ret.empty()) {
+            break;
+        }
+    }
+    return ret;
+}
+
+}  // namespace paths
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+ * SpscQueue - bounded lock free queue, one producer thread and one consumer thread
+ *
+ * A ring of slots indexed by two counters : the producer only writes the tail,
+ * the consumer only writes the head, each one reads the other with acquire.
+ * tryPush/tryPop never block, the caller decides how to wait (see backoff).
+ */
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+namespace kunai {
+namespace utils {
+
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> m_slots;
+    size_t m_mask{};
+    alignas(64) std::atomic<size_t> m_head{0U};  // next slot to pop, written by the consumer
+    alignas(64) std::atomic<size_t> m_tail{0U};  // next slot to push, written by the producer
+
+public:
+    // the capacity is rounded up to a power of 2
+    explicit SpscQueue(size_t aCapacity) {
+        size_t capacity{1U};
+        while (capacity < aCapacity) {
+            capacity <<= 1U;
+        }
+        m_slots.resize(capacity);
+        m_mask = capacity - 1U;
+    }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // producer only. false if full, arValue is then untouched
+    bool tryPush(T& arValue) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(arValue);
+        m_tail.store(tail + 1U, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only. false if empty
+    bool tryPop(T& aoValue) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        aoValue = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1U, std::memory_order_release);
+        return true;
+    }
+
+    // approximate when called concurrently with push or pop
+    size_t size() const {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return m_slots.size();
+    }
+};
+
+// wait step of a polling loop : yields first, then sleeps, so a waiting thread
+// doesn't steal the core of the thread it waits for
+inline void backoff(uint32_t& arSpins) {
+    if (arSpins < 64U) {
+        ++arSpins;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,87 @@
+#include "substring_matcher.h"
+
+namespace kunai {
+namespace utils {
+
+SubStringMatcher::SubStringMatcher(const std::vector<std::string>& aNeedles) {
+    m_nodes.emplace_back();
+    for (size_t idx = 0U; idx < aNeedles.size(); ++idx) {
+        const auto& needle = aNeedles[idx];
+        if (needle.empty()) {
+            m_emptyNeedles.push_back(static_cast<uint32_t>(idx));
+            continue;
+        }
+        uint32_t node{};
+        for (const auto c : needle) {
+            const auto lower = toLowerAscii(c);
+            auto child = m_getChild(node, lower);
+            if (child == 0U) {
+                child = static_cast<uint32_t>(m_nodes.size());
+                m_nodes[node].children.emplace_back(lower, child);
+                m_nodes.emplace_back();
+                if (node == 0U) {
+                    m_rootChildren[static_cast<uint8_t>(lower)] = child;
+                }
+            }
+            node = child;
+        }
+        m_nodes[node].needles.push_back(static_cast<uint32_t>(idx));
+    }
+
+    // fail links by breadth, a node only needs the ones of the shorter prefixes
+    std::vector<uint32_t> queue;
+    for (const auto& child : m_nodes[0].children) {
+        queue.push_back(child.second);
+    }
+    for (size_t idx = 0U; idx < queue.size(); ++idx) {
+        const auto node = queue[idx];
+        for (const auto& child : m_nodes[node].children) {
+            auto fail = m_nodes[node].fail;
+            while ((fail != 0U) && (m_getChild(fail, child.first) == 0U)) {
+                fail = m_nodes[fail].fail;
+            }
+            const auto childFail = m_getChild(fail, child.first);
+            m_nodes[child.second].fail = childFail;
+            m_nodes[child.second].output = m_nodes[childFail].needles.empty() ? m_nodes[childFail].output : childFail;
+            queue.push_back(child.second);
+        }
+    }
+}
+
+bool SubStringMatcher::isMatching(std::string_view aHaystack) const {
+    if (!m_emptyNeedles.empty()) {
+        return true;
+    }
+    uint32_t node{};
+    for (const auto c : aHaystack) {
+        node = m_step(node, toLowerAscii(c));
+        if (!m_nodes[node].needles.empty() || (m_nodes[node].output != 0U)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t SubStringMatcher::m_getChild(uint32_t aNode, char aLowerChar) const {
+    if (aNode == 0U) {
+        return m_rootChildren[static_cast<uint8_t>(aLowerChar)];
+    }
+    for (const auto& child : m_nodes[aNode].children) {
+        if (child.first == aLowerChar) {
+            return child.second;
+        }
+    }
+    return 0U;
+}
+
+uint32_t SubStringMatcher::m_step(uint32_t aNode, char aLowerChar) const {
+    auto next = m_getChild(aNode, aLowerChar);
+    while ((next == 0U) && (aNode != 0U)) {
+        aNode = m_nodes[aNode].fail;
+        next = m_getChild(aNode, aLowerChar);
+    }
+    return next;
+}
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+ * SubStringMatcher - case insensitive search of many needles at once
+ *
+ * The pointed files are matched as sub-strings of the graph paths. Testing
+ * each path against each file costs paths x files; this automaton
+ * (Aho-Corasick) reads each path once whatever the count of files.
+ * Like the sql LIKE, only the ascii letters are case insensitive.
+ */
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+namespace kunai {
+namespace utils {
+
+class SubStringMatcher {
+private:
+    struct Node {
+        std::vector<std::pair<char, uint32_t>> children;  // lower case char -> node
+        uint32_t fail{};                                   // longest proper suffix of the node being a prefix of a needle
+        uint32_t output{};                                 // nearest fail node ending needles, 0 if none
+        std::vector<uint32_t> needles;                     // indexes of the needles ending here
+    };
+    std::vector<Node> m_nodes;
+    std::array<uint32_t, 256> m_rootChildren{};  // most of the steps restart from the root
+    std::vector<uint32_t> m_emptyNeedles;         // an empty needle is in every path
+
+public:
+    explicit SubStringMatcher(const std::vector<std::string>& aNeedles);
+
+    // true if one of the needles is in aHaystack
+    bool isMatching(std::string_view aHaystack) const;
+
+    // calls aCallback(needleIdx) for each needle found in aHaystack, a needle may be given several times
+    template <typename TCallback>
+    void forEachMatch(std::string_view aHaystack, TCallback aCallback) const {
+        for (const auto idx : m_emptyNeedles) {
+            aCallback(idx);
+        }
+        uint32_t node{};
+        for (const auto c : aHaystack) {
+            node = m_step(node, toLowerAscii(c));
+            for (auto found = m_nodes[node].needles.empty() ? m_nodes[node].output : node; found != 0U; found = m_nodes[found].output) {
+                for (const auto idx : m_nodes[found].needles) {
+                    aCallback(idx);
+                }
+            }
+        }
+    }
+
+    static char toLowerAscii(char aChar) {
+        return ((aChar >= 'A') && (aChar <= 'Z')) ? static_cast<char>(aChar - 'A' + 'a') : aChar;
+    }
+
+private:
+    // 0 (the root) if none
+    uint32_t m_getChild(uint32_t aNode, char aLowerChar) const;
+    // next state of the automaton
+    uint32_t m_step(uint32_t aNode, char aLowerChar) const;
+};
+
+}  // namespace utils
+}  // namespace kunai
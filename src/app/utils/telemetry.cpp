@@ -0,0 +1,88 @@
+#include "telemetry.h"
+
+#include <app/utils/file_lock.h>
+
+#include <deque>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace kunai {
+namespace utils {
+
+Telemetry::Telemetry(const fs::path& aFilePath, const fs::path& aLockFilePath) : m_filePath(aFilePath), m_lockFilePath(aLockFilePath) {
+}
+
+void Telemetry::record(const std::string& aKey, double aValue) const {
+    const auto lock = FileLock::create(m_lockFilePath, LOCK_TIMEOUT_MS);
+    if (lock.first == nullptr) {
+        return;
+    }
+    std::ostringstream line;
+    line << aKey << '\t' << aValue << '\n';
+    {
+        std::ofstream file(m_filePath, std::ios::app | std::ios::binary);
+        if (!file.is_open()) {
+            return;
+        }
+        const auto str = line.str();
+        file.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+    std::error_code ec;
+    const auto fileSize = fs::file_size(m_filePath, ec);
+    if (!ec && (fileSize > MAX_FILE_SIZE)) {
+        m_compact(KEPT_RECORDS);
+    }
+}
+
+std::map<std::string, Telemetry::Measure> Telemetry::aggregate() const {
+    std::map<std::string, Measure> ret;
+    std::ifstream file(m_filePath, std::ios::binary);
+    std::string line;
+    while (std::getline(file, line)) {
+        const auto tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;  // partial line
+        }
+        const auto value = std::strtod(line.c_str() + tab + 1U, nullptr);
+        auto& measure = ret[line.substr(0U, tab)];
+        measure.last = value;
+        measure.mean += (value - measure.mean) / static_cast<double>(++measure.count);
+    }
+    return ret;
+}
+
+void Telemetry::m_compact(size_t aMaxRecords) const {
+    std::deque<std::string> lines;
+    {
+        std::ifstream file(m_filePath, std::ios::binary);
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+            if (lines.size() > aMaxRecords) {
+                lines.pop_front();
+            }
+        }
+    }
+    fs::path tmpFilePath = m_filePath;
+    tmpFilePath += ".tmp";
+    {
+        std::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        for (const auto& line : lines) {
+            file << line << '\n';
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmpFilePath, m_filePath, ec);
+    if (ec) {
+        fs::remove(tmpFilePath, ec);
+    }
+}
+
+}  // namespace utils
+}  // namespace kunai
@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * Telemetry - append only sidecar of the timing measures
+ *
+ * Each measure is appended as a "key \t value" line, so recording it never
+ * touches the database and never takes its lock. stats aggregates the lines.
+ * Beyond MAX_FILE_SIZE, the append compacts the file to its last KEPT_RECORDS records.
+ * The appends and the compaction hold a lock file of their own, so an append
+ * of another process is never lost by the rename of the compaction.
+ */
+
+#include <map>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace kunai {
+namespace utils {
+
+class Telemetry {
+public:
+    static constexpr uint64_t MAX_FILE_SIZE{64U * 1024U};
+    static constexpr size_t KEPT_RECORDS{1000U};
+    static constexpr uint32_t LOCK_TIMEOUT_MS{1000U};
+
+    struct Measure {
+        double last{};
+        double mean{};
+        size_t count{};
+    };
+
+private:
+    std::filesystem::path m_filePath;
+    std::filesystem::path m_lockFilePath;
+
+public:
+    Telemetry(const std::filesystem::path& aFilePath, const std::filesystem::path& aLockFilePath);
+
+    // append a measure, and compact the file beyond MAX_FILE_SIZE. a failure is ignored, telemetry is best effort
+    void record(const std::string& aKey, double aValue) const;
+
+    // measures by key
+    std::map<std::string, Measure> aggregate() const;
+
+private:
+    // keep only the last aMaxRecords records. the lock must be held
+    void m_compact(size_t aMaxRecords) const;
+};
+
+}  // namespace utils
+}  // namespace kunai